@@ -3,114 +3,417 @@
 #include "SFML/Graphics.hpp"
 #include "utility.hpp"
 #include "settings.hpp"
-#include "NeuralNetwork.hpp"
+#include "simd.hpp"
+#include "spatial_grid.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <vector>
 
 
-class Agent : AgentSettings
+// every agent of every game, stored as a structure of arrays. agent `slot` of game `game` is entry slot * games + game
+// of each array, so one slot over a range of games is a contiguous run and the physics step handles 8 games at a
+// time. the rules are the ones the old per-object Agent class had, step for step, so the results did not change
+class AgentStore : AgentSettings
 {
 public:
-	explicit Agent(const sf::Vector2f& Position) : position(Position) {}
+	static constexpr unsigned slots = GameSettings::agentsPergame;
+	static constexpr unsigned observed = NetSettings::observedAgents; // how many other agents a network sees
 
-	// hard reset all of the agent's information for another game
-	void reset()
+	std::vector<float> x, y;           // position
+	std::vector<float> vx, vy;         // velocity
+	std::vector<float> startX, startY; // where the agent started this game
+	std::vector<float> score;          // lower is better for the learner
+	std::vector<int32_t> tagged;       // 1 while the agent is it
+	std::vector<int32_t> cooldown;     // frames until a freshly tagged agent can tag back
+	std::vector<int32_t> aliveTime;    // frames played this game
+	std::vector<int32_t> timesTagged;  // how often the agent was tagged this game
+
+
+	void resize(const unsigned games)
 	{
-		aliveTime = 0; network_score = 0; m_tagCooldown = 0; tagged = false;
-		m_velocity = { 0.f, 0.f }; position = randPointOutCircle(Settings::bounds);
+		m_games = games;
+		const size_t count = static_cast<size_t>(games) * slots;
+
+		for (std::vector<float>* values : { &x, &y, &vx, &vy, &startX, &startY, &score })
+			values->assign(count, 0.f);
+
+		for (std::vector<int32_t>* values : { &tagged, &cooldown, &aliveTime, &timesTagged })
+			values->assign(count, 0);
+
+		useSpatialGrid(slots >= GameSettings::spatialGridAgents);
+	}
+
+	// with the grid, an agent only checks the agents in the cells around it for collisions instead of every agent
+	// of its game. worth it once a game has enough agents, see GameSettings::spatialGridAgents and --bench-physics
+	void useSpatialGrid(const bool enabled)
+	{
+		m_useGrid = enabled;
+		if (!enabled)
+			return;
+
+		m_grid.resize(Settings::bounds, radius + radius, m_games, m_games * slots);
+		for (unsigned slot = 0; slot < slots; ++slot)
+		{
+			for (unsigned game = 0; game < m_games; ++game)
+				moved(index(slot, game), game);
+		}
 	}
 
+	[[nodiscard]] bool usingSpatialGrid() const { return m_useGrid; }
 
-	void update(NeuralNetwork& network, std::vector<Agent>& agents)
+	[[nodiscard]] unsigned games() const { return m_games; }
+	[[nodiscard]] unsigned index(const unsigned slot, const unsigned game) const { return slot * m_games + game; }
+
+	[[nodiscard]] sf::Vector2f position(const unsigned slot, const unsigned game) const { return { x[index(slot, game)], y[index(slot, game)] }; }
+	[[nodiscard]] sf::Vector2f velocity(const unsigned slot, const unsigned game) const { return { vx[index(slot, game)], vy[index(slot, game)] }; }
+	[[nodiscard]] sf::Vector2f startPosition(const unsigned slot, const unsigned game) const { return { startX[index(slot, game)], startY[index(slot, game)] }; }
+
+	void setPosition(const unsigned slot, const unsigned game, const sf::Vector2f& position)
 	{
-		// computing the velocity from the neural network
-		setNetworkInputs(network, agents);
-		network.compute_output();
-		position += { network.outputs[0] * 5, network.outputs[1] * 5};
+		x[index(slot, game)] = position.x;
+		y[index(slot, game)] = position.y;
+		moved(index(slot, game), game);
+	}
 
-		// preventing overlap with the game border or other agent(s)
-		agentCollisions(agents);
-		border(Settings::bounds, position, radius);
+	// remembers where every agent starts this game
+	void markStartPositions()
+	{
+		startX = x;
+		startY = y;
+	}
 
-		aliveTime++;
+	// the same for one game, the others may be mid episode
+	void markStartPositions(const unsigned game)
+	{
+		for (unsigned slot = 0; slot < slots; ++slot)
+		{
+			startX[index(slot, game)] = x[index(slot, game)];
+			startY[index(slot, game)] = y[index(slot, game)];
+		}
+	}
 
-		network_score += tagged;
 
-		if (tagged && m_tagCooldown > 0)
+	// hard reset all of the game's agents for another game
+	void reset(const unsigned game)
+	{
+		for (unsigned slot = 0; slot < slots; ++slot)
 		{
-			m_tagCooldown--;
+			const unsigned i = index(slot, game);
+			aliveTime[i] = 0; score[i] = 0; cooldown[i] = 0; tagged[i] = 0; timesTagged[i] = 0;
+			vx[i] = 0.f; vy[i] = 0.f;
+			setPosition(slot, game, randPointOutCircle(Settings::bounds));
 		}
 	}
 
 
-private:
-	void setNetworkInputs(NeuralNetwork& network, std::vector<Agent>& agents) const
+	// writes the view agent `slot` of `game` has of its game into a network's input layer
+	void setNetworkInputs(const unsigned slot, const unsigned game, float* inputs) const
 	{
+		const unsigned self = index(slot, game);
+
 		// the agent's personal information comes first so it does not get confused
-		sf::Vector2f relativeBounds = relativePosToCircle(Settings::bounds, position);
-		network.inputs[0] = relativeBounds.x;          // position Y border
-		network.inputs[1] = relativeBounds.y;          // position Y border
-		network.inputs[2] = m_velocity.x / maxSpeed;   // velocity X
-		network.inputs[3] = m_velocity.y / maxSpeed;   // velocity Y
-		network.inputs[4] = (tagged == 1) ? 1.f : -1.f;
+		sf::Vector2f relativeBounds = relativePosToCircle(Settings::bounds, position(slot, game));
+		inputs[0] = relativeBounds.x;      // position Y border
+		inputs[1] = relativeBounds.y;      // position Y border
+		inputs[2] = vx[self] / maxSpeed;   // velocity X
+		inputs[3] = vy[self] / maxSpeed;   // velocity Y
+		inputs[4] = (tagged[self] == 1) ? 1.f : -1.f;
+
+		// then the nearest other agents, nearest first. the ones a small game does not have are all zeros
+		const NearestAgents nearest = nearestAgents(self, game);
+		unsigned input = 4;
+		for (unsigned n = 0; n < observed; ++n)
+		{
+			if (n >= nearest.count)
+			{
+				for (unsigned value = 0; value < 5; ++value)
+					inputs[++input] = 0.f;
+				continue;
+			}
 
-		// other agent information is separated
-		unsigned index = 4;
-		for (Agent& agent : agents)
+			const unsigned i = nearest.agent[n];
+			relativeBounds = relativePosToCircle(Settings::bounds, { x[i], y[i] });
+			inputs[++input] = relativeBounds.x;      // position X
+			inputs[++input] = relativeBounds.y;      // position Y
+			inputs[++input] = vx[i] / maxSpeed;      // velocity X
+			inputs[++input] = vy[i] / maxSpeed;      // velocity Y
+			inputs[++input] = (tagged[i] == 1) ? 1.f : -1.f;
+		}
+	}
+
+
+	// moves agent `slot` of games [begin, end) by its network's outputs (game g's are at outputs + (g - begin) * stride),
+	// then pushes it apart from (and maybe tags) the other agents of its game and keeps it inside the border.
+	// the sequential tick: agent 1 acts on the world agent 0 has just left behind
+	void act(const unsigned slot, const unsigned begin, const unsigned end, const float* outputs, const unsigned outputStride)
+	{
+		integrate(slot, begin, end, outputs, outputStride);
+
+		unsigned game = begin;
+#ifdef AITAG_X86
+		if (s_avx2 && !m_useGrid)
 		{
-			if (agent.position == position) continue;
+			for (; game + Simd::width <= end; game += Simd::width)
+				physicsAvx2(slot, game);
+		}
+#endif
+		for (; game < end; ++game)
+			physics(slot, game);
+	}
+
+
+	// the two phase tick is integrate() for every slot, with every network having seen the same frame, then one
+	// resolve() over the games
+
+	// only moves agent `slot` of games [begin, end) by its network's outputs, laid out like in act()
+	void integrate(const unsigned slot, const unsigned begin, const unsigned end, const float* outputs, const unsigned outputStride)
+	{
+		for (unsigned game = begin; game < end; ++game)
+		{
+			const float* output = outputs + (game - begin) * outputStride;
+			x[index(slot, game)] += output[0] * 5;
+			y[index(slot, game)] += output[1] * 5;
+			moved(index(slot, game), game);
+		}
+	}
 
-			relativeBounds = relativePosToCircle(Settings::bounds, agent.position);
-			network.inputs[++index] = relativeBounds.x;               // position X
-			network.inputs[++index] = relativeBounds.y;               // position Y
-			network.inputs[++index] = agent.m_velocity.x / maxSpeed;  // velocity X
-			network.inputs[++index] = agent.m_velocity.y / maxSpeed;  // velocity Y
-			network.inputs[++index] = (agent.tagged == 1) ? 1.f : -1.f;
+	// pushes every touching pair of games [begin, end) apart once (the first agent of a pair that can tag, tags),
+	// then scores every agent and keeps it inside the border
+	void resolve(const unsigned begin, const unsigned end)
+	{
+		unsigned game = begin;
+#ifdef AITAG_X86
+		if (s_avx2 && !m_useGrid)
+		{
+			for (; game + Simd::width <= end; game += Simd::width)
+				resolveAvx2(game);
 		}
+#endif
+		for (; game < end; ++game)
+			resolve(game);
 	}
 
 
-	void agentCollisions(std::vector<Agent>& agents)
+private:
+	unsigned m_games = 0;
+	bool m_useGrid = false;
+	SpatialGrid m_grid; // only kept up to date while m_useGrid
+
+	inline static const bool s_avx2 = Simd::cpuHasAvx2();
+
+	// the agents filed in the cells around an agent, in index order (which is slot order)
+	struct Nearby
 	{
-		for (Agent& agent : agents)
+		unsigned agent[slots];
+		unsigned count = 0;
+		unsigned next = 0; // the first one not passed yet
+		int32_t cell = SpatialGrid::none;
+	};
+
+	// whether `other` is filed in the cells around `self`, for `other` counting up. a collision that pushed `self`
+	// into another cell gathers its neighbours again, the agents it now touches would be missed otherwise, so the
+	// grid finds every pair the every pair loops find
+	bool inReach(Nearby& nearby, const unsigned self, const unsigned game, const unsigned other) const
+	{
+		if (m_grid.cellOf(self) != nearby.cell)
 		{
-			if (agent.position != position)
+			nearby.cell = m_grid.cellOf(self);
+			nearby.count = std::min(m_grid.gather(game, { x[self], y[self] }, nearby.agent, slots), slots); // a game holds slots agents
+			for (unsigned i = 1; i < nearby.count; ++i) // insertion sort, there are a handful at most
+				for (unsigned j = i; j > 0 && nearby.agent[j - 1] > nearby.agent[j]; --j)
+					std::swap(nearby.agent[j - 1], nearby.agent[j]);
+			nearby.next = static_cast<unsigned>(std::lower_bound(nearby.agent, nearby.agent + nearby.count, other) - nearby.agent);
+		}
+
+		while (nearby.next < nearby.count && nearby.agent[nearby.next] < other)
+			++nearby.next;
+		return nearby.next < nearby.count && nearby.agent[nearby.next] == other;
+	}
+
+	// an agent skips every agent standing exactly where it is, itself included
+	[[nodiscard]] bool samePosition(const unsigned a, const unsigned b) const { return x[a] == x[b] && y[a] == y[b]; }
+
+	[[nodiscard]] bool canTag(const unsigned agent) const
+	{
+		return tagged[agent] && cooldown[agent] <= 0 && aliveTime[agent] > static_cast<int32_t>(GameSettings::gameStartImmunity);
+	}
+
+
+	// the `observed` nearest agents seen so far, nearest first. offer() is a partial selection: a candidate is
+	// insertion sorted into the short list or dropped, so picking k out of n costs n compares plus a few shifts.
+	// equally far agents are ordered by index so the grid and the every agent search pick the same ones
+	struct NearestAgents
+	{
+		unsigned agent[observed]{};
+		float distSq[observed]{};
+		unsigned count = 0;
+
+		void offer(const unsigned candidate, const float candidateDistSq)
+		{
+			const auto closer = [&](const unsigned n) { return candidateDistSq < distSq[n] || (candidateDistSq == distSq[n] && candidate < agent[n]); };
+			if (count == observed && !closer(observed - 1))
+				return;
+
+			unsigned n = count < observed ? count++ : observed - 1;
+			for (; n > 0 && closer(n - 1); --n)
 			{
-				agentCollision(&agent);
+				agent[n] = agent[n - 1];
+				distSq[n] = distSq[n - 1];
+			}
+			agent[n] = candidate;
+			distSq[n] = candidateDistSq;
+		}
+
+		[[nodiscard]] bool full() const { return count == observed; }
+	};
+
+	// every other agent of the game standing somewhere else is a candidate. with the grid the search walks rings of
+	// cells outwards and stops once no agent further out could be closer than the farthest one kept
+	[[nodiscard]] NearestAgents nearestAgents(const unsigned self, const unsigned game) const
+	{
+		NearestAgents nearest{};
+		const auto offer = [&](const unsigned other)
+		{
+			if (!samePosition(self, other))
+				nearest.offer(other, distSquared({ x[self], y[self] }, { x[other], y[other] }));
+		};
+
+		if (!m_useGrid)
+		{
+			for (unsigned otherSlot = 0; otherSlot < slots; ++otherSlot)
+				offer(index(otherSlot, game));
+			return nearest;
+		}
 
-				const float diam = (Settings::bounds.radius - radius) * 2;
-				const float distNorm = distSquared(position, agent.position) / (diam * diam);
-				if (tagged) network_score += distNorm + 0.5f;
-				//else network_score += abs((1.f - distNorm) - 0.5f);
+		for (int ring = 0; ; ++ring)
+		{
+			const float bound = m_grid.ringDistance(ring);
+			if (nearest.full() && nearest.distSq[observed - 1] < bound * bound)
+				break;
+			if (!m_grid.visitRing(game, { x[self], y[self] }, ring, offer))
+				break;
+		}
+		return nearest;
+	}
+
+
+	// refiles an agent of `game` in the grid after it moved
+	void moved(const unsigned agent, const unsigned game)
+	{
+		if (m_useGrid)
+			m_grid.place(agent, game, { x[agent], y[agent] });
+	}
+
+
+	void physics(const unsigned slot, const unsigned game)
+	{
+		const unsigned self = index(slot, game);
+
+		if (m_useGrid)
+		{
+			// only the agents in the cells around this one can touch it. the pairs are met in slot order with the
+			// chase score taken in between, like the loop below does, so the grid scores the same. an agent that is
+			// not it has nothing to score and goes straight to the next agent in reach
+			Nearby nearby{};
+			for (unsigned otherSlot = 0; otherSlot < slots; ++otherSlot)
+			{
+				unsigned other = index(otherSlot, game);
+				bool touching = inReach(nearby, self, game, other);
+				if (!touching && !tagged[self])
+				{
+					if (nearby.next == nearby.count)
+						break;
+					other = nearby.agent[nearby.next];
+					otherSlot = other / m_games;
+					touching = true;
+				}
+				if (samePosition(self, other)) continue;
+
+				if (touching)
+					agentCollision(game, self, other, false);
+				chaseScore(self, other);
 			}
+
+			endFrame(self, game);
+			return;
 		}
+
+		// preventing overlap with the other agent(s)
+		for (unsigned otherSlot = 0; otherSlot < slots; ++otherSlot)
+		{
+			const unsigned other = index(otherSlot, game);
+			if (samePosition(self, other)) continue;
+
+			agentCollision(game, self, other, false);
+			chaseScore(self, other);
+		}
+
+		endFrame(self, game);
 	}
 
 
-	void tagLogistics(Agent* agent)
+	void resolve(const unsigned game)
 	{
-		if (tagged && m_tagCooldown <= 0 && aliveTime > GameSettings::gameStartImmunity)
+		for (unsigned a = 0; a < slots; ++a)
 		{
-			agent->tagged = true;
-			//agent->network_score += taggedPenalty;
-			//network_score -= taggedPenalty;
-			agent->m_tagCooldown = tagcooldownamount;
-			tagged = false;
+			const unsigned self = index(a, game);
+
+			if (m_useGrid)
+			{
+				// the same pairs in the same order as the loop below, only the ones in reach
+				Nearby nearby{};
+				for (unsigned b = a + 1; b < slots; ++b)
+				{
+					unsigned other = index(b, game);
+					if (!inReach(nearby, self, game, other))
+					{
+						if (nearby.next == nearby.count)
+							break;
+						other = nearby.agent[nearby.next];
+						b = other / m_games;
+					}
+					if (!samePosition(self, other))
+						agentCollision(game, self, other, true);
+				}
+				continue;
+			}
+
+			for (unsigned b = a + 1; b < slots; ++b)
+			{
+				if (!samePosition(self, index(b, game)))
+					agentCollision(game, self, index(b, game), true);
+			}
 		}
+
+		// every agent is scored from the same resolved positions before any of them is moved back inside the border
+		for (unsigned slot = 0; slot < slots; ++slot)
+			chaseScores(index(slot, game), game);
+
+		for (unsigned slot = 0; slot < slots; ++slot)
+			endFrame(index(slot, game), game);
 	}
 
 
-	bool agentCollision(Agent* agent)
+	// with `mutual` the other agent may tag this one too, otherwise only this one can tag
+	void agentCollision(const unsigned game, const unsigned self, const unsigned other, const bool mutual)
 	{
+		const sf::Vector2f position{ x[self], y[self] };
+		const sf::Vector2f otherPosition{ x[other], y[other] };
 
-		const sf::Vector2f relative_position = agent->position - position;
-		const float dist_squared = distSquared(this->position, agent->position);
+		const sf::Vector2f relative_position = otherPosition - position;
+		const float dist_squared = distSquared(position, otherPosition);
 		constexpr float sum_radii = radius + radius;
 
 		if (dist_squared > sum_radii * sum_radii || dist_squared < 0)
-			return false;
+			return;
 
-		tagLogistics(agent);
+		// tagging
+		if (canTag(self))
+			tag(self, other);
+		else if (mutual && canTag(other))
+			tag(other, self);
 
 		const float dist = std::sqrt(dist_squared);
 		const sf::Vector2f normal_vector = relative_position / dist;
@@ -118,26 +421,220 @@ private:
 
 		// Move the agents to prevent them from interpenetrating
 		const sf::Vector2f displacement = correction * (radius / sum_radii);
-		position -= displacement;
-		agent->position += displacement;
+		x[self] -= displacement.x;  y[self] -= displacement.y;
+		x[other] += displacement.x; y[other] += displacement.y;
+		moved(self, game);
+		moved(other, game);
+	}
 
-		return true;
+	void tag(const unsigned from, const unsigned to)
+	{
+		tagged[to] = 1;
+		cooldown[to] = tagcooldownamount;
+		timesTagged[to]++;
+		tagged[from] = 0;
 	}
 
+	// the chaser is rewarded for the distance it keeps
+	void chaseScore(const unsigned self, const unsigned other)
+	{
+		const float diam = (Settings::bounds.radius - radius) * 2;
+		const float distNorm = distSquared({ x[self], y[self] }, { x[other], y[other] }) / (diam * diam);
+		if (tagged[self]) score[self] += distNorm + 0.5f;
+	}
 
-	void applyFriction(const float strength) { m_velocity /= strength; }
+	// chaseScore() against every other agent of the game. only whoever is it scores, so that is one agent's worth
+	// of work per game however many agents there are
+	void chaseScores(const unsigned self, const unsigned game)
+	{
+		if (!tagged[self])
+			return;
 
+		for (unsigned otherSlot = 0; otherSlot < slots; ++otherSlot)
+		{
+			if (!samePosition(self, index(otherSlot, game)))
+				chaseScore(self, index(otherSlot, game));
+		}
+	}
 
-public:
-	sf::Vector2f gameStartPos{};
-	sf::Vector2f position{};
-	sf::Vector2f m_velocity{};
-	sf::Vector2f m_accelaration{};
+	// the game border, then the per frame counters
+	void endFrame(const unsigned self, const unsigned game)
+	{
+		sf::Vector2f clamped{ x[self], y[self] };
+		border(Settings::bounds, clamped, radius);
+		x[self] = clamped.x;
+		y[self] = clamped.y;
+		moved(self, game);
 
-	float network_score = 0;
-	bool tagged = false;
+		aliveTime[self]++;
 
-private:
-	unsigned m_tagCooldown = 0;
-	unsigned aliveTime = 0;
-};
\ No newline at end of file
+		score[self] += static_cast<float>(tagged[self]);
+
+		if (tagged[self] && cooldown[self] > 0)
+		{
+			cooldown[self]--;
+		}
+	}
+
+
+#ifdef AITAG_X86
+	// the avx2 kernels below do a frame for games [game, game + 8), one game per lane. they use the same operations in
+	// the same order as the scalar code above (and no fma) so every lane gives exactly what the scalar code would
+
+	AITAG_TARGET_AVX2_NOFMA __m256 loadFloats(const std::vector<float>& values, const unsigned i) const { return _mm256_loadu_ps(&values[i]); }
+	AITAG_TARGET_AVX2_NOFMA __m256i loadInts(const std::vector<int32_t>& values, const unsigned i) const { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&values[i])); }
+	AITAG_TARGET_AVX2_NOFMA static void store(std::vector<float>& values, const unsigned i, const __m256 lanes) { _mm256_storeu_ps(&values[i], lanes); }
+	AITAG_TARGET_AVX2_NOFMA static void store(std::vector<int32_t>& values, const unsigned i, const __m256i lanes) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(&values[i]), lanes); }
+
+	// one agent of 8 games, held in registers while a kernel works on it
+	struct AgentLanes
+	{
+		__m256 x, y, score;
+		__m256i tagged, cooldown, aliveTime, timesTagged;
+	};
+
+	AITAG_TARGET_AVX2_NOFMA AgentLanes loadLanes(const unsigned i) const
+	{
+		return { loadFloats(x, i), loadFloats(y, i), loadFloats(score, i), loadInts(tagged, i), loadInts(cooldown, i), loadInts(aliveTime, i), loadInts(timesTagged, i) };
+	}
+
+	AITAG_TARGET_AVX2_NOFMA void storeLanes(const unsigned i, const AgentLanes& agent)
+	{
+		store(x, i, agent.x); store(y, i, agent.y); store(score, i, agent.score);
+		store(tagged, i, agent.tagged); store(cooldown, i, agent.cooldown); store(aliveTime, i, agent.aliveTime); store(timesTagged, i, agent.timesTagged);
+	}
+
+	AITAG_TARGET_AVX2_NOFMA static __m256 apartAvx2(const AgentLanes& a, const AgentLanes& b)
+	{
+		return _mm256_or_ps(_mm256_cmp_ps(b.x, a.x, _CMP_NEQ_UQ), _mm256_cmp_ps(b.y, a.y, _CMP_NEQ_UQ));
+	}
+
+	AITAG_TARGET_AVX2_NOFMA static __m256i canTagAvx2(const AgentLanes& agent)
+	{
+		const __m256i isTagged = _mm256_andnot_si256(_mm256_cmpeq_epi32(agent.tagged, _mm256_setzero_si256()), _mm256_set1_epi32(-1));
+		return _mm256_and_si256(isTagged, _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(1), agent.cooldown),
+			_mm256_cmpgt_epi32(agent.aliveTime, _mm256_set1_epi32(GameSettings::gameStartImmunity))));
+	}
+
+	AITAG_TARGET_AVX2_NOFMA static void tagAvx2(AgentLanes& from, AgentLanes& to, const __m256i tags)
+	{
+		to.tagged = _mm256_blendv_epi8(to.tagged, _mm256_set1_epi32(1), tags);
+		to.cooldown = _mm256_blendv_epi8(to.cooldown, _mm256_set1_epi32(tagcooldownamount), tags);
+		to.timesTagged = _mm256_sub_epi32(to.timesTagged, tags); // tagged lanes are -1
+		from.tagged = _mm256_blendv_epi8(from.tagged, _mm256_setzero_si256(), tags);
+	}
+
+	// agentCollision() for the lanes where a and b are `apart`
+	AITAG_TARGET_AVX2_NOFMA static void collisionAvx2(AgentLanes& self, AgentLanes& other, const __m256 apart, const bool mutual)
+	{
+		constexpr float sum_radii = radius + radius;
+
+		const __m256 dx = _mm256_sub_ps(other.x, self.x);
+		const __m256 dy = _mm256_sub_ps(other.y, self.y);
+		const __m256 distSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+		const __m256 tooFar = _mm256_or_ps(_mm256_cmp_ps(distSq, _mm256_set1_ps(sum_radii * sum_radii), _CMP_GT_OQ), _mm256_cmp_ps(distSq, _mm256_setzero_ps(), _CMP_LT_OQ));
+		const __m256 touching = _mm256_andnot_ps(tooFar, apart);
+
+		const __m256i selfTags = _mm256_and_si256(_mm256_castps_si256(touching), canTagAvx2(self));
+		const __m256i otherTags = mutual ? _mm256_andnot_si256(selfTags, _mm256_and_si256(_mm256_castps_si256(touching), canTagAvx2(other))) : _mm256_setzero_si256();
+		tagAvx2(self, other, selfTags);
+		tagAvx2(other, self, otherTags);
+
+		const __m256 dist = _mm256_sqrt_ps(distSq);
+		const __m256 overlap = _mm256_sub_ps(_mm256_set1_ps(sum_radii), dist);
+		const __m256 half = _mm256_set1_ps(0.5f);
+		const __m256 pushX = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(overlap, _mm256_div_ps(dx, dist)), half), _mm256_set1_ps(radius / sum_radii));
+		const __m256 pushY = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(overlap, _mm256_div_ps(dy, dist)), half), _mm256_set1_ps(radius / sum_radii));
+
+		self.x = _mm256_blendv_ps(self.x, _mm256_sub_ps(self.x, pushX), touching);
+		self.y = _mm256_blendv_ps(self.y, _mm256_sub_ps(self.y, pushY), touching);
+		other.x = _mm256_blendv_ps(other.x, _mm256_add_ps(other.x, pushX), touching);
+		other.y = _mm256_blendv_ps(other.y, _mm256_add_ps(other.y, pushY), touching);
+	}
+
+	AITAG_TARGET_AVX2_NOFMA static void chaseScoreAvx2(AgentLanes& self, const AgentLanes& other, const __m256 apart)
+	{
+		const float diam = (Settings::bounds.radius - radius) * 2;
+
+		const __m256 dx = _mm256_sub_ps(other.x, self.x);
+		const __m256 dy = _mm256_sub_ps(other.y, self.y);
+		const __m256 distNorm = _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_set1_ps(diam * diam));
+		const __m256 chasing = _mm256_andnot_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(self.tagged, _mm256_setzero_si256())), apart);
+		self.score = _mm256_blendv_ps(self.score, _mm256_add_ps(self.score, _mm256_add_ps(distNorm, _mm256_set1_ps(0.5f))), chasing);
+	}
+
+	AITAG_TARGET_AVX2_NOFMA static void endFrameAvx2(AgentLanes& self)
+	{
+		// border()
+		const float borderRadius = Settings::bounds.radius - radius;
+		const __m256 centerX = _mm256_set1_ps(Settings::bounds.position.x);
+		const __m256 centerY = _mm256_set1_ps(Settings::bounds.position.y);
+		const __m256 fromCenterX = _mm256_sub_ps(self.x, centerX);
+		const __m256 fromCenterY = _mm256_sub_ps(self.y, centerY);
+		const __m256 centerDistSq = _mm256_add_ps(_mm256_mul_ps(fromCenterX, fromCenterX), _mm256_mul_ps(fromCenterY, fromCenterY));
+		const __m256 outside = _mm256_cmp_ps(centerDistSq, _mm256_set1_ps(borderRadius * borderRadius), _CMP_GT_OQ);
+		const __m256 centerDist = _mm256_sqrt_ps(centerDistSq);
+		self.x = _mm256_blendv_ps(self.x, _mm256_add_ps(centerX, _mm256_mul_ps(_mm256_div_ps(fromCenterX, centerDist), _mm256_set1_ps(borderRadius))), outside);
+		self.y = _mm256_blendv_ps(self.y, _mm256_add_ps(centerY, _mm256_mul_ps(_mm256_div_ps(fromCenterY, centerDist), _mm256_set1_ps(borderRadius))), outside);
+
+		self.aliveTime = _mm256_add_epi32(self.aliveTime, _mm256_set1_epi32(1));
+		self.score = _mm256_add_ps(self.score, _mm256_cvtepi32_ps(self.tagged));
+
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i cooling = _mm256_andnot_si256(_mm256_cmpeq_epi32(self.tagged, zero), _mm256_cmpgt_epi32(self.cooldown, zero));
+		self.cooldown = _mm256_add_epi32(self.cooldown, cooling); // cooling lanes are -1
+	}
+
+
+	AITAG_TARGET_AVX2_NOFMA void physicsAvx2(const unsigned slot, const unsigned game)
+	{
+		AgentLanes self = loadLanes(index(slot, game));
+
+		for (unsigned otherSlot = 0; otherSlot < slots; ++otherSlot)
+		{
+			if (otherSlot == slot)
+				continue; // every lane stands where it stands, nothing would happen
+
+			AgentLanes other = loadLanes(index(otherSlot, game));
+			const __m256 apart = apartAvx2(self, other);
+
+			collisionAvx2(self, other, apart, false);
+			chaseScoreAvx2(self, other, apart);
+
+			storeLanes(index(otherSlot, game), other);
+		}
+
+		endFrameAvx2(self);
+		storeLanes(index(slot, game), self);
+	}
+
+
+	AITAG_TARGET_AVX2_NOFMA void resolveAvx2(const unsigned game)
+	{
+		AgentLanes agents[slots];
+		for (unsigned slot = 0; slot < slots; ++slot)
+			agents[slot] = loadLanes(index(slot, game));
+
+		for (unsigned a = 0; a < slots; ++a)
+		{
+			for (unsigned b = a + 1; b < slots; ++b)
+				collisionAvx2(agents[a], agents[b], apartAvx2(agents[a], agents[b]), true);
+		}
+
+		for (unsigned slot = 0; slot < slots; ++slot)
+		{
+			for (unsigned otherSlot = 0; otherSlot < slots; ++otherSlot)
+			{
+				if (otherSlot != slot)
+					chaseScoreAvx2(agents[slot], agents[otherSlot], apartAvx2(agents[slot], agents[otherSlot]));
+			}
+		}
+
+		for (unsigned slot = 0; slot < slots; ++slot)
+		{
+			endFrameAvx2(agents[slot]);
+			storeLanes(index(slot, game), agents[slot]);
+		}
+	}
+#endif
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "settings.hpp"
+#include "NeuralNetwork.hpp"
+
+
+// runs the forward pass of one network slot (e.g. every game's learner) for many games at once instead of one
+// compute_output() call per agent. the inputs of all games sit in one contiguous [games x inputs] matrix and every
+// layer is evaluated over a whole range of those rows before the next one.
+// the weights are copied out of the games' networks layer-major: all games' weights of layer 0, then all of layer 1...
+// so sweeping one layer over the batch reads memory front to back. every row is padded to the simd width with zeros
+// and evaluated with the same Simd::denseTanh kernel as compute_output(), so both give the same results.
+// a slot where every game plays the same network (the opponent) shares that one network instead of holding copies,
+// each layer then runs over the whole range of games with each weight row loaded once for a group of games
+class BatchedInference : NetSettings
+{
+	static constexpr unsigned weightLayers = NetworkLayers - 1;
+
+	unsigned m_games = 0;
+	const Neural9Network* m_shared = nullptr;        // when set every game uses this network and m_weights is empty
+	std::vector<float> m_weights[weightLayers];     // [layer][game][node][padded input]
+	std::vector<float> m_biases[weightLayers];      // [layer][game][node]
+	std::vector<float> m_activations[NetworkLayers]; // [layer][game][padded node], layer 0 holds the inputs
+
+	static constexpr unsigned width(const unsigned layer) { return Simd::padded(NN_dims[layer]); }
+
+
+public:
+	explicit BatchedInference(const unsigned games = 0, const bool sharedWeights = false) { resize(games, sharedWeights); }
+
+	void resize(const unsigned games, const bool sharedWeights = false)
+	{
+		m_games = games;
+		const size_t weightSets = sharedWeights ? 0 : games;
+		for (unsigned layer = 0; layer < weightLayers; ++layer)
+		{
+			m_weights[layer].assign(weightSets * NN_dims[layer + 1] * width(layer), 0.f);
+			m_biases[layer].assign(weightSets * NN_dims[layer + 1], 0.f);
+		}
+
+		for (unsigned layer = 0; layer < NetworkLayers; ++layer)
+			m_activations[layer].assign(static_cast<size_t>(games) * width(layer), 0.f);
+	}
+
+	static constexpr unsigned outputStride = Simd::padded(NN_dims[NetworkLayers - 1]); // floats between two games' outputs
+
+	[[nodiscard]] unsigned games() const { return m_games; }
+
+	// copies a game's network into the batch, has to be called whenever that network changes
+	void loadWeights(const unsigned game, const Neural9Network& network)
+	{
+		// the network already stores every layer as the same [nodes][padded inputs] block a game has in the batch
+		for (unsigned layer = 0; layer < weightLayers; ++layer)
+		{
+			const unsigned nodes = NN_dims[layer + 1];
+
+			std::copy_n(network.layerWeights(layer), nodes * width(layer), &m_weights[layer][static_cast<size_t>(game) * nodes * width(layer)]);
+			std::copy_n(network.layerBiases(layer), nodes, &m_biases[layer][static_cast<size_t>(game) * nodes]);
+		}
+	}
+
+	// every game of the batch plays `network` from now on, it is read in place so it has to outlive the batch's use of it.
+	// only for a batch resized with sharedWeights
+	void shareWeights(const Neural9Network* network) { m_shared = network; }
+
+	float* inputs(const unsigned game) { return &m_activations[0][static_cast<size_t>(game) * width(0)]; }
+
+	[[nodiscard]] const float* outputs(const unsigned game) const
+	{
+		return &m_activations[NetworkLayers - 1][static_cast<size_t>(game) * width(NetworkLayers - 1)];
+	}
+
+
+	// evaluates rows [begin, end). different workers may compute different ranges at the same time
+	void compute(const unsigned begin, const unsigned end)
+	{
+		for (unsigned layer = 0; layer < weightLayers; ++layer)
+		{
+			if (m_shared != nullptr)
+				computeSharedLayer(layer, begin, end);
+			else
+				computeLayer(layer, begin, end);
+		}
+	}
+
+
+private:
+	void computeSharedLayer(const unsigned layer, const unsigned begin, const unsigned end)
+	{
+		Simd::denseTanhShared(m_shared->layerWeights(layer), width(layer), m_shared->layerBiases(layer),
+			&m_activations[layer][static_cast<size_t>(begin) * width(layer)], width(layer),
+			&m_activations[layer + 1][static_cast<size_t>(begin) * width(layer + 1)], NN_dims[layer + 1], end - begin);
+	}
+
+	void computeLayer(const unsigned layer, const unsigned begin, const unsigned end)
+	{
+		const unsigned inputs = width(layer);
+		const unsigned nodes  = NN_dims[layer + 1];
+
+		for (unsigned game = begin; game < end; ++game)
+		{
+			Simd::denseTanh(&m_weights[layer][static_cast<size_t>(game) * nodes * inputs], inputs,
+				&m_biases[layer][static_cast<size_t>(game) * nodes],
+				&m_activations[layer][static_cast<size_t>(game) * inputs], inputs,
+				&m_activations[layer + 1][static_cast<size_t>(game) * width(layer + 1)], nodes);
+		}
+	}
+};
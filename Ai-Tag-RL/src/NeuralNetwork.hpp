@@ -3,280 +3,231 @@
 
 #include "utility.hpp"
 #include "settings.hpp"
-
-#pragma once
+#include "simd.hpp"
 
 #include <vector>
+#include <array>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <span>
+#include <cmath>
+
+
+// a feed forward network whose shape is fixed at compile time. all the parameters sit in one contiguous array: every
+// layer's weights, layer after layer, then every layer's biases. each layer's weights are a [nodes][padded inputs]
+// block with the rows padded to the simd width (zeros, see simd.hpp), so a network only takes the memory its dims need.
+// every size and offset is a constant, the layer loop is unrolled.
+// the network only holds its parameters, the values flowing through it live in an Activations the caller owns, so one
+// network can be evaluated by many agents (on many threads) at once
+template <unsigned... Dims>
+class DenseNetwork
+{
+public:
+    static constexpr unsigned layerCount = sizeof...(Dims);
+    static constexpr unsigned dims[layerCount] = { Dims... };
+    static constexpr unsigned weightLayers = layerCount - 1; // no weights in front of the input layer
 
+    static_assert(layerCount >= 2, "a network needs at least an input and an output layer");
 
-struct Layer
-{
-	Layer(const uint64_t neurons_count, const uint64_t prev_count)
-		: weights(neurons_count)
-		, values(neurons_count)
-		, bias(neurons_count)
-	{
-		for (std::vector<float>& v : weights) {
-			v.resize(prev_count);
-		}
-	}
-
-	uint64_t getNeuronsCount() const
-	{
-		return bias.size();
-	}
-
-	uint64_t getWeightsCount() const
-	{
-		return weights.front().size();
-	}
-
-	void process(const std::vector<float>& inputs)
-	{
-		const uint64_t neurons_count = bias.size();
-		const uint64_t inputs_count = inputs.size();
-		// For each neuron
-		for (uint64_t i(0); i < neurons_count; ++i) {
-			float result = bias[i];
-			// Compute weighted sum of inputs
-			for (uint64_t j(0); j < inputs_count; ++j) {
-				result += weights[i][j] * inputs[j];
-			}
-			// Output result
-			values[i] = tanh(4.0f * result);
-		}
-	}
-
-	void print() const
-	{
-		std::cout << "--- layer ---" << std::endl;
-		const uint64_t neurons_count = values.size();
-		for (uint64_t i(0); i < neurons_count; ++i) {
-			const uint64_t inputs_count = getWeightsCount();
-			// Compute weighted sum of inputs
-			std::cout << "Neuron " << i << " bias " << bias[i] << std::endl;
-			for (uint64_t j(0); j < inputs_count; ++j) {
-				std::cout << weights[i][j] << " ";
-			}
-			std::cout << std::endl;
-		}
-		std::cout << "--- end ---\n" << std::endl;
-	}
-
-	std::vector<std::vector<float>> weights;
-	std::vector<float> values;
-	std::vector<float> bias;
-};
+    // the weight rows of layer `layer` (the weights between layers `layer` and `layer + 1`) are this many floats apart
+    static constexpr unsigned rowStride(const unsigned layer) { return Simd::padded(dims[layer]); }
 
+    static constexpr unsigned weightOffset(const unsigned layer)
+    {
+        unsigned offset = 0;
+        for (unsigned i = 0; i < layer; ++i)
+            offset += dims[i + 1] * rowStride(i);
+        return offset;
+    }
 
-struct Network
-{
-	Network()
-		: input_size(0)
-		, last_input(0)
-	{}
-
-	Network(const uint64_t input_size_)
-		: input_size(input_size_)
-		, last_input(input_size_)
-	{}
-
-	Network(const std::vector<uint64_t>& layers_sizes)
-		: input_size(layers_sizes[0])
-		, last_input(input_size)
-	{
-		for (uint64_t i(1); i < layers_sizes.size(); ++i) {
-			addLayer(layers_sizes[i]);
-		}
-	}
-
-	void addLayer(const uint64_t neurons_count)
-	{
-		if (!layers.empty()) {
-			layers.emplace_back(neurons_count, layers.back().getNeuronsCount());
-		}
-		else {
-			layers.emplace_back(neurons_count, input_size);
-		}
-	}
-
-	const std::vector<float>& execute(const std::vector<float>& input)
-	{
-		last_input = input;
-		if (input.size() == input_size) {
-			layers.front().process(input);
-			const uint64_t layers_count = layers.size();
-			for (uint64_t i(1); i < layers_count; ++i) {
-				layers[i].process(layers[i - 1].values);
-			}
-		}
-
-		return layers.back().values;
-	}
-
-	uint64_t getParametersCount() const
-	{
-		uint64_t result = 0;
-		for (const Layer& layer : layers) {
-			result += layer.bias.size() * (1 + layer.weights.front().size());
-		}
-		return result;
-	}
-
-	static uint64_t getParametersCount(const std::vector<uint64_t>& layers_sizes)
-	{
-		uint64_t count = 0;
-		for (uint64_t i(1); i < layers_sizes.size(); ++i) {
-			count += layers_sizes[i] * (1 + layers_sizes[i - 1]);
-		}
-		return count;
-	}
-
-	uint64_t input_size;
-	std::vector<Layer> layers;
-	std::vector<float> last_input;
-};
+    static constexpr unsigned biasOffset(const unsigned layer)
+    {
+        unsigned offset = 0;
+        for (unsigned i = 0; i < layer; ++i)
+            offset += dims[i + 1];
+        return offset;
+    }
 
+    static constexpr unsigned weightCount = weightOffset(weightLayers);
+    static constexpr unsigned biasCount   = biasOffset(weightLayers);
+    static constexpr unsigned parameterCount = weightCount + biasCount;
+    static constexpr unsigned widestLayer = std::max({ 1u, Simd::padded(Dims)... });
 
+    struct Activations
+    {
+        alignas(32) std::array<float, Simd::padded(dims[0])> inputs = {};
+        alignas(32) std::array<float, Simd::padded(dims[weightLayers])> outputs = {};
+        alignas(32) std::array<float, widestLayer> hidden[2] = {}; // the layers in between take turns in these
+    };
 
-using Weight = float;
-using Bias   = float;
 
-using Node  = Weight[NetSettings::largestLayer];
-using LayerWeights = Node[NetSettings::largestnonInpLayer];
-using LayerBiases = Bias[NetSettings::largestnonInpLayer];
+private:
+    // 1 for every real parameter, 0 for the row padding which has to stay zero
+    static constexpr std::array<float, parameterCount> parameterMask = []
+    {
+        std::array<float, parameterCount> mask{};
+        for (unsigned layer = 0; layer < weightLayers; ++layer)
+        {
+            for (unsigned node = 0; node < dims[layer + 1]; ++node)
+            {
+                for (unsigned input = 0; input < dims[layer]; ++input)
+                    mask[weightOffset(layer) + node * rowStride(layer) + input] = 1.f;
+            }
+        }
 
+        for (unsigned bias = weightCount; bias < parameterCount; ++bias)
+            mask[bias] = 1.f;
+        return mask;
+    }();
 
-class Neural9Network : NetSettings
-{
-    static void mutate_value(float& value, const float rate, const float range)
+    static constexpr unsigned mutationBatch = 64;     // random numbers drawn per fillUniform call
+    static constexpr float    skipSamplingBelow = 0.25f; // rates under this jump between mutations, above it use a mask
+
+    // adds a uniform [-range, range) nudge to every value of the block with probability `rate`
+    static void mutateBlock(float* values, const float* mask, const unsigned count, const float rate, const float range)
     {
-        if (RandomDist::rand01float() < rate)
+        if (rate <= 0.f || range <= 0.f)
+            return;
+
+        alignas(32) float draws[mutationBatch];
+        alignas(32) float nudges[mutationBatch];
+
+        if (rate < skipSamplingBelow)
         {
-            value += RandomDist::randRange(-range, range);
+            // the gap to the next mutated value is geometric, drawing it directly costs one draw per mutation
+            // instead of one per value
+            const float logKeep = std::log1p(-rate);
+            unsigned index = 0;
+            while (true)
+            {
+                RandomDist::fillUniform(draws, mutationBatch);
+                RandomDist::fillUniform(nudges, mutationBatch, -range, range);
+
+                for (unsigned i = 0; i < mutationBatch; ++i)
+                {
+                    const float gap = std::floor(std::log1p(-draws[i]) / logKeep);
+                    if (gap >= static_cast<float>(count - index))
+                        return;
+
+                    index += static_cast<unsigned>(gap);
+                    values[index] += mask[index] * nudges[i];
+                    if (++index == count)
+                        return;
+                }
+            }
+        }
+
+        // high rates: a bernoulli mask over the whole block, branch free so the compiler vectorises it
+        for (unsigned begin = 0; begin < count; begin += mutationBatch)
+        {
+            const unsigned batch = std::min(mutationBatch, count - begin);
+            RandomDist::fillUniform(draws, batch);
+            RandomDist::fillUniform(nudges, batch, -range, range);
+
+            for (unsigned i = 0; i < batch; ++i)
+                values[begin + i] += static_cast<float>(draws[i] < rate) * mask[begin + i] * nudges[i];
         }
     }
 
+    template <unsigned Layer>
+    void forwardLayer(Activations& values, const Simd::DenseLayerKernel denseTanh) const
+    {
+        const float* in = Layer == 0 ? values.inputs.data() : values.hidden[(Layer - 1) % 2].data();
+        float* out = Layer == weightLayers - 1 ? values.outputs.data() : values.hidden[Layer % 2].data();
+
+        denseTanh(layerWeights(Layer), rowStride(Layer), layerBiases(Layer), in, rowStride(Layer), out, dims[Layer + 1]);
+    }
+
 
 public:
-    Neural9Network()
+    DenseNetwork()
     {
         // initilising weights
     	mutate(this, 0.4f, 0.4f, 0.4f, 0.4f);
     }
 
-    void compute_output()
+    // runs values.inputs through the network into values.outputs. the kernel can be swapped to compare the
+    // vectorised pass against the scalar one (benchmarkForwardPass)
+    void compute_output(Activations& values, const Simd::DenseLayerKernel denseTanh = Simd::denseTanh) const
     {
-    	outputs = inputs;
-
-        for (unsigned layer_idx = 0; layer_idx < NetworkLayers - 1; ++layer_idx) // each network layer
+        // every node's dot product and tanh, vectorised when the cpu allows it (see simd.hpp)
+        [&]<unsigned... Layer>(std::integer_sequence<unsigned, Layer...>)
         {
-	        for (unsigned node_idx = 0; node_idx < NN_dims[layer_idx + 1]; ++node_idx) // each node in the network
-	        {
-                float dotted = biases[layer_idx][node_idx];
-
-                for (unsigned weight_idx = 0; weight_idx < NN_dims[layer_idx]; ++weight_idx) // calculating the dot product
-                    dotted += weights[layer_idx][node_idx][weight_idx] * outputs[weight_idx];
-
-                //temp[node_idx] = dotted;
-                temp[node_idx] = tanh(dotted * 2.0);
-                //temp[node] = (0 < layer && layer < NetworkLayers - 1) ? std::min(0.0, dotted) : dotted;
-	        }
-        	outputs = temp;
-        }
+            (forwardLayer<Layer>(values, denseTanh), ...);
+        }(std::make_integer_sequence<unsigned, weightLayers>{});
     }
 
 
-    void mutate(Neural9Network* net, 
-        const float w_rate = weight_mutation_rate, const float w_range = weight_mutation_range,
-        const float b_rate = bias_mutation_rate, const float b_range = bias_mutation_range) const
+    // copies this network's parameters into `net` (one block copy) and mutates them there
+    void mutate(DenseNetwork* net,
+        const float w_rate = NetSettings::weight_mutation_rate, const float w_range = NetSettings::weight_mutation_range,
+        const float b_rate = NetSettings::bias_mutation_rate, const float b_range = NetSettings::bias_mutation_range) const
     {
-        // `NetworkLayers - 1` as we do not have input weights
-        for (unsigned layer = 0; layer < NetworkLayers - 1; ++layer) // each network layer
-        {
-            for (unsigned node = 0; node < NN_dims[layer + 1]; ++node)
-            {
-                for (unsigned weight = 0; weight < NN_dims[layer]; ++weight)
-                {
-                    net->weights[layer][node][weight] = weights[layer][node][weight];
-                    mutate_value(net->weights[layer][node][weight], w_rate, w_range);
-                }
-            }
+        net->parameters = parameters;
 
-            for (unsigned bias = 0; bias < NN_dims[layer + 1]; ++bias)
-            {
-                net->biases[layer][bias] = biases[layer][bias];
-                mutate_value(net->biases[layer][bias], b_rate, b_range);
-            }
-        }
+        mutateBlock(net->parameters.data(), parameterMask.data(), weightCount, w_rate, w_range);
+        mutateBlock(net->parameters.data() + weightCount, parameterMask.data() + weightCount, biasCount, b_rate, b_range);
     }
 
-    void jsonFormat(nlohmann::json& writeTo)
+    // adds scale * direction[i] to every real parameter, the padding stays zero
+    void addScaled(const float* direction, const float scale)
     {
-        return writeTo.push_back({ {"weights", weights}, {"biases", biases}});
+        for (unsigned i = 0; i < parameterCount; ++i)
+            parameters[i] += scale * direction[i] * parameterMask[i];
     }
 
+    // weights[layer][node][input] and biases[layer][node], without the padding
+    void jsonFormat(nlohmann::json& writeTo) const
+    {
+        nlohmann::json jsonWeights = nlohmann::json::array();
+        nlohmann::json jsonBiases  = nlohmann::json::array();
 
-public:
-    LayerWeights weights[NetworkLayers - 1];
-    LayerBiases biases[NetworkLayers-1];
+        for (unsigned layer = 0; layer < weightLayers; ++layer)
+        {
+            nlohmann::json nodes = nlohmann::json::array();
+            for (unsigned node = 0; node < dims[layer + 1]; ++node)
+                nodes.push_back(std::vector<float>(&weight(layer, node, 0), &weight(layer, node, 0) + dims[layer]));
 
-    std::array<float, largestLayer> inputs  = {};
-    std::array<float, largestLayer> outputs = {};
-    std::array<float, largestLayer> temp    = {};
-};
+            jsonWeights.push_back(nodes);
+            jsonBiases.push_back(std::vector<float>(layerBiases(layer), layerBiases(layer) + dims[layer + 1]));
+        }
 
+        writeTo.push_back({ {"weights", jsonWeights}, {"biases", jsonBiases} });
+    }
 
-class ReinforcementLearning
-{
-public:
-    static constexpr int8_t   snapshot_window = 10;           // amount of networks stored in history, oldest gets overwrittten
-    static constexpr uint16_t snapshot_frequency = 250;       // how often a network gets logged, stores a play strategy
-    static constexpr uint16_t swap_steps = 5;                 // how often the network the learning agent plays against changes
-    static constexpr float    play_lastest_model_ratio = 0.5; // chance of choosing a random past network over the latest one
-    std::vector<Neural9Network> policy{};                      // where all the past networks are stored
 
-    uint8_t current_index = 0; // incharge of overwriting older networks
-    uint8_t actual_size = 0;
-    Neural9Network* chosenNetwork = nullptr;
+    float& weight(const unsigned layer, const unsigned node, const unsigned input) { return parameters[weightOffset(layer) + node * rowStride(layer) + input]; }
+    [[nodiscard]] const float& weight(const unsigned layer, const unsigned node, const unsigned input) const { return parameters[weightOffset(layer) + node * rowStride(layer) + input]; }
 
+    float& bias(const unsigned layer, const unsigned node) { return parameters[weightCount + biasOffset(layer) + node]; }
+    [[nodiscard]] const float& bias(const unsigned layer, const unsigned node) const { return parameters[weightCount + biasOffset(layer) + node]; }
 
-    ReinforcementLearning()
-    {
-        policy.resize(snapshot_window);
+    // the [nodes][rowStride(layer)] block of one layer
+    float* layerWeights(const unsigned layer) { return parameters.data() + weightOffset(layer); }
+    [[nodiscard]] const float* layerWeights(const unsigned layer) const { return parameters.data() + weightOffset(layer); }
+    [[nodiscard]] const float* layerBiases(const unsigned layer) const { return parameters.data() + weightCount + biasOffset(layer); }
 
-        // the first neural network in the policy should be completly random
-        add_neural_network({}, snapshot_frequency);
-    }
+    // the whole genome, padding included (the padding must stay zero)
+    std::span<float, parameterCount> parameterSpan() { return parameters; }
+    [[nodiscard]] std::span<const float, parameterCount> parameterSpan() const { return parameters; }
 
 
-    void add_neural_network(const Neural9Network& neural_network, const unsigned genaration_count)
-    {
-        if (genaration_count % snapshot_frequency != 0)
-            return;
+public:
+    alignas(32) std::array<float, parameterCount> parameters = {}; // weights of every layer, then biases of every layer
+};
 
-        std::cout << "[Notice]: Adding Neural Network \n";
-        policy[current_index] = neural_network;
-        increment();
-    }
 
+// DenseNetwork<Dims[0], Dims[1], ...> for a constexpr array of layer sizes
+template <const auto& Dims, typename = std::make_integer_sequence<unsigned, static_cast<unsigned>(std::size(Dims))>>
+struct DenseNetworkFromDims;
 
-    Neural9Network* get_network(const unsigned genaration_count)
-    {
-        if (chosenNetwork == nullptr || genaration_count % swap_steps == 0)
-        {
-            if (RandomDist::rand01float() > play_lastest_model_ratio && actual_size > 1)
-                chosenNetwork = &policy[RandomDist::randRange(0u, static_cast<unsigned>(actual_size))];
-            chosenNetwork = &policy[current_index];
-        }
-        return chosenNetwork;
-    }
+template <const auto& Dims, unsigned... Layer>
+struct DenseNetworkFromDims<Dims, std::integer_sequence<unsigned, Layer...>>
+{
+    using type = DenseNetwork<Dims[Layer]...>;
+};
 
 
-    void reset_information() { actual_size = 0; current_index = 0; chosenNetwork = nullptr; }
-    void increment()
-    {
-        actual_size += actual_size < policy.size();
-        current_index += (current_index == snapshot_window - 1) ? -(snapshot_window - 1) : 1;
-    }
-};
\ No newline at end of file
+using Neural9Network = DenseNetworkFromDims<NetSettings::NN_dims>::type;
+using NeuralNetwork = Neural9Network;
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "settings.hpp"
+#include "NeuralNetwork.hpp"
+#include "league.hpp"
+
+
+// the binary checkpoint saveNetworkData() writes: this header, then raw blocks at the offsets it gives, each starting
+// on a 64 byte boundary so they can be used straight out of the mapped file. the blocks are the best network's
+// parameters, the league's index (League::Snapshot as it is in memory) and either the snapshot archive's file name or,
+// when the league never got an archive, every snapshot's parameters one after the other. the rng needs nothing but
+// the run seed, every stream is keyed on it and the generation. json is only an export (see exportNetworkData).
+// version 2 added `id`, the name the deltas saved on top of it go by (see CheckpointDelta)
+struct alignas(64) CheckpointHeader
+{
+	static constexpr uint32_t current_version = 2;
+	static constexpr char file_magic[8] = { 'A', 'I', 'T', 'A', 'G', 'C', 'K', 'P' };
+	static constexpr unsigned max_layers = 8;
+	static constexpr uint64_t alignment = 64;
+
+	char magic[8];
+	uint32_t version;
+	uint32_t layers;
+	uint32_t dims[max_layers]; // NetSettings::NN_dims, the rest zero
+	uint32_t parameters;       // NeuralNetwork::parameterCount, padding included
+	uint32_t generation;
+	uint64_t runSeed;
+	double runTime;
+	float learnerRating;
+	uint32_t latest;
+	uint32_t snapshots;        // entries in the league's index
+	uint32_t inlineNetworks;   // networks in the file, 0 when they are in the archive
+	uint64_t bestOffset;
+	uint64_t indexOffset;
+	uint64_t networksOffset;
+	uint64_t archiveOffset;    // the archive's file name, next to the checkpoint
+	uint64_t archiveLength;
+	uint64_t id;               // 0 in version 1, which no delta follows
+
+	static constexpr uint64_t aligned(const uint64_t offset) { return (offset + alignment - 1) / alignment * alignment; }
+
+	// a header for this build's network shape
+	static CheckpointHeader make()
+	{
+		static_assert(NetSettings::NetworkLayers <= max_layers, "the header has room for max_layers layers");
+
+		CheckpointHeader header{};
+		std::memcpy(header.magic, file_magic, sizeof(file_magic));
+		header.version = current_version;
+		header.layers = NetSettings::NetworkLayers;
+		for (unsigned layer = 0; layer < NetSettings::NetworkLayers; ++layer)
+			header.dims[layer] = NetSettings::NN_dims[layer];
+		header.parameters = NeuralNetwork::parameterCount;
+		return header;
+	}
+
+	[[nodiscard]] bool isCheckpoint() const { return std::memcmp(magic, file_magic, sizeof(file_magic)) == 0; }
+
+	// whether `count` blocks of `each` bytes from `offset` end inside a file of `size` bytes, without overflowing
+	static constexpr bool within(const uint64_t offset, const uint64_t count, const uint64_t each, const uint64_t size)
+	{
+		return offset <= size && (count == 0 || count <= (size - offset) / each);
+	}
+
+	// whether every block the header points at lies inside a file of `size` bytes, the index where it can be read
+	// in place, and the league it describes is one that can be loaded
+	[[nodiscard]] bool inside(const uint64_t size) const
+	{
+		constexpr uint64_t networkBytes = sizeof(float) * NeuralNetwork::parameterCount;
+		return snapshots != 0 && inlineNetworks <= snapshots && indexOffset % alignof(League::Snapshot) == 0
+			&& within(bestOffset, 1, networkBytes, size)
+			&& within(indexOffset, snapshots, sizeof(League::Snapshot), size)
+			&& within(networksOffset, inlineNetworks, networkBytes, size)
+			&& within(archiveOffset, archiveLength, 1, size);
+	}
+
+	// whether the networks in it are the ones this build runs
+	[[nodiscard]] bool fits() const
+	{
+		const CheckpointHeader expected = make();
+		return version >= 1 && version <= expected.version && parameters == expected.parameters && layers == expected.layers
+			&& std::memcmp(dims, expected.dims, sizeof(dims)) == 0;
+	}
+};
+
+
+
+// one save that only holds what changed since the save before it: the counters, the best network and the index
+// entries of the snapshots that joined or were rated since, as `changed` Entry after the best network. the deltas
+// are appended to `<save>.delta` one after the other and name the checkpoint they go on top of by its id, loading
+// replays them over it in order and stops at the first one that is torn (checksum) or belongs to an older checkpoint.
+// a save is a delta until the log is as big as a full checkpoint, then a full one is written and the log started
+// over, so a save costs what changed plus at most as much again, however big the league gets
+struct alignas(64) CheckpointDelta
+{
+	static constexpr char file_magic[8] = { 'A', 'I', 'T', 'A', 'G', 'D', 'L', 'T' };
+
+	struct Entry
+	{
+		uint32_t slot;
+		League::Snapshot snapshot;
+	};
+
+	char magic[8];
+	uint64_t base;         // the CheckpointHeader::id it goes on top of
+	uint64_t checksum;     // fnv-1a of the whole record, this field counted as zero
+	uint32_t sequence;     // 0 for the first delta on a checkpoint
+	uint32_t bytes;        // the whole record, padding included
+	uint32_t generation;
+	uint32_t latest;
+	uint64_t runSeed;
+	double runTime;
+	float learnerRating;
+	uint32_t snapshots;    // entries in the league's index after it
+	uint32_t changed;
+
+	static constexpr uint64_t bestOffset() { return CheckpointHeader::aligned(sizeof(CheckpointDelta)); }
+	static constexpr uint64_t entriesOffset() { return CheckpointHeader::aligned(bestOffset() + sizeof(float) * NeuralNetwork::parameterCount); }
+	static constexpr uint64_t size(const uint64_t changed) { return CheckpointHeader::aligned(entriesOffset() + sizeof(Entry) * changed); }
+
+	static uint64_t hash(const char* bytes, const size_t size)
+	{
+		constexpr size_t field = offsetof(CheckpointDelta, checksum);
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < size; ++i)
+		{
+			const bool skipped = i >= field && i < field + sizeof(uint64_t);
+			hash = (hash ^ (skipped ? 0u : static_cast<uint8_t>(bytes[i]))) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	// whether the record at the start of `bytes` (`size` of them left in the log) is whole and goes on top of `base`
+	static bool valid(const char* bytes, const size_t size, const uint64_t base, const uint32_t sequence)
+	{
+		if (size < sizeof(CheckpointDelta))
+			return false;
+		CheckpointDelta delta{};
+		std::memcpy(&delta, bytes, sizeof(delta));
+		return std::memcmp(delta.magic, file_magic, sizeof(file_magic)) == 0 && delta.base == base && delta.sequence == sequence
+			&& delta.bytes <= size && delta.bytes == CheckpointDelta::size(delta.changed) && delta.checksum == hash(bytes, delta.bytes);
+	}
+};
+
+static_assert(std::is_trivially_copyable_v<CheckpointHeader> && std::is_trivially_copyable_v<CheckpointDelta> && std::is_trivially_copyable_v<League::Snapshot>, "all are written and read as raw bytes");
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+// writes checkpoints on its own thread so the training thread only pays for copying one out (Simulation::
+// checkpointBytes). a checkpoint is written to `<file>.tmp`, synced to disk and renamed over the file, so a crash
+// leaves either the old checkpoint or the new one, never half of one, and the delta log behind it is removed once it
+// is. the snapshot archive the checkpoint names is synced before the rename and the directory after it, so the
+// checkpoint on disk never names networks that are not. deltas (see CheckpointDelta) are appended to the log and
+// synced, after the archive, a torn one is found by its checksum. a write that fails is kept for failed(). at most
+// one write is in flight: whatever is submitted while one is being written waits in the single pending slot. a newer
+// checkpoint replaces everything there, only the latest state is worth writing, deltas queue up behind it and go
+// out in one write, every one of them is needed to replay the ones after it
+class CheckpointWriter
+{
+	struct Job
+	{
+		std::string file{};
+		std::vector<char> checkpoint{}; // empty when there is none to write
+		std::string log{};
+		std::vector<char> deltas{};
+		std::string archive{};          // the snapshot archive both name, empty when the networks are inline
+	};
+
+	std::mutex m_mutex{};
+	std::condition_variable m_wake{};
+	std::condition_variable m_idle{};
+	Job m_pending{};
+	bool m_hasPending = false;
+	bool m_writing = false;
+	bool m_stop = false;
+	std::atomic<bool> m_failed = false;
+	std::thread m_thread{};             // last, it starts on everything above
+
+	// writes `bytes` to the end of `path` (or over it) and waits for them to be on disk
+	static bool writeSynced(const std::string& path, const std::vector<char>& bytes, const bool append)
+	{
+		std::FILE* file = std::fopen(path.c_str(), append ? "ab" : "wb");
+		if (file == nullptr)
+			return false;
+
+		bool ok = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size() && std::fflush(file) == 0;
+#ifdef _WIN32
+		ok = ok && _commit(_fileno(file)) == 0;
+#else
+		ok = ok && fsync(fileno(file)) == 0;
+#endif
+		return std::fclose(file) == 0 && ok;
+	}
+
+	// renames `from` over `to` and waits for the rename itself to be on disk (the directory entry, not the file)
+	static bool renameSynced(const std::string& from, const std::string& to)
+	{
+#ifdef _WIN32
+		return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+		std::error_code error{};
+		std::filesystem::rename(from, to, error);
+		if (error)
+			return false;
+
+		const std::filesystem::path parent = std::filesystem::absolute(to, error).parent_path();
+		const int directory = ::open(parent.c_str(), O_RDONLY | O_DIRECTORY);
+		if (directory == -1)
+			return false;
+		const bool ok = fsync(directory) == 0;
+		::close(directory);
+		return ok;
+#endif
+	}
+
+	static bool write(const Job& job)
+	{
+		if (!job.archive.empty() && !MappedFile::sync(job.archive))
+			return false;
+
+		if (!job.checkpoint.empty())
+		{
+			const std::string temporary = job.file + ".tmp";
+			if (!writeSynced(temporary, job.checkpoint, false) || !renameSynced(temporary, job.file))
+				return false;
+			std::error_code error{};
+			std::filesystem::remove(job.log, error); // its deltas name the checkpoint that was just replaced
+		}
+		return job.deltas.empty() || writeSynced(job.log, job.deltas, true);
+	}
+
+	void writerLoop()
+	{
+		std::unique_lock lock(m_mutex);
+		while (true)
+		{
+			m_wake.wait(lock, [this] { return m_hasPending || m_stop; });
+			if (!m_hasPending)
+				return;
+
+			Job job = std::exchange(m_pending, {});
+			m_hasPending = false;
+			m_writing = true;
+			lock.unlock();
+
+			if (!write(job))
+			{
+				std::cerr << "[error]: could not write the checkpoint " << (job.checkpoint.empty() ? job.log : job.file) << "\n";
+				m_failed.store(true, std::memory_order_release);
+			}
+
+			lock.lock();
+			m_writing = false;
+			m_idle.notify_all();
+		}
+	}
+
+
+public:
+	CheckpointWriter() : m_thread([this] { writerLoop(); }) {}
+
+	// whatever is still pending is written before the thread goes
+	~CheckpointWriter()
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_stop = true;
+		}
+		m_wake.notify_one();
+		m_thread.join();
+	}
+
+	CheckpointWriter(const CheckpointWriter&) = delete;
+	CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+	// queues the checkpoint `bytes` to be written to `file`, starting the delta log `log` over, and returns straight
+	// away. `archive` is the snapshot archive it names, if it names one
+	void submit(const std::string& file, std::vector<char> bytes, const std::string& log, const std::string& archive)
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_pending = { file, std::move(bytes), log, {}, archive };
+			m_hasPending = true;
+		}
+		m_wake.notify_one();
+	}
+
+	// queues the delta `bytes` to be appended to the log `log` after everything submitted before it
+	void append(const std::string& log, const std::vector<char>& bytes, const std::string& archive)
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_pending.log = log;
+			m_pending.deltas.insert(m_pending.deltas.end(), bytes.begin(), bytes.end());
+			m_pending.archive = archive;
+			m_hasPending = true;
+		}
+		m_wake.notify_one();
+	}
+
+	// whether a write failed since the last call. what was built on top of it (the deltas after a checkpoint that is
+	// not on disk) cannot be replayed, the next save has to be a whole checkpoint
+	bool failed() { return m_failed.exchange(false, std::memory_order_acq_rel); }
+
+	// blocks until every checkpoint submitted so far is on disk
+	void wait()
+	{
+		std::unique_lock lock(m_mutex);
+		m_idle.wait(lock, [this] { return !m_hasPending && !m_writing; });
+	}
+};
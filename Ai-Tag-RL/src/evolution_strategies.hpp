@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include "settings.hpp"
+#include "utility.hpp"
+#include "NeuralNetwork.hpp"
+
+
+// openai style evolution strategies over the parallel games. instead of mutating the best network of the generation,
+// one centre network is moved along an estimate of the score's gradient. game 0 plays the centre itself, the other
+// games come in antithetic pairs: one plays the centre plus sigma times a stretch of gaussian noise, the other the
+// centre minus the same stretch, from the same start, so whatever the noise did not cause cancels out of the pair.
+// the noise is not drawn per game but read from one table that only depends on the run seed, a game's network is
+// fully described by (centre, table offset, sign), so spreading the games over processes would only need the offsets
+// and the scores sent around, never the weights.
+// a step replaces the scores by their centred ranks (only the order counts, so a single runaway game cannot swamp
+// it), then moves the centre along the rank weighted sum of every pair's noise
+class EvolutionStrategies : NetSettings
+{
+	static constexpr unsigned parameters = NeuralNetwork::parameterCount;
+
+	std::vector<float> m_noise{};
+	std::vector<unsigned> m_offsets{}; // where each pair's noise starts in the table this generation
+	std::vector<float> m_step{};
+	NeuralNetwork m_centre{};
+	bool m_started = false;
+
+	[[nodiscard]] static unsigned pairs(const unsigned games) { return (games - 1) / 2; }
+
+
+public:
+	[[nodiscard]] bool started() const { return m_started; }
+	[[nodiscard]] const NeuralNetwork& centre() const { return m_centre; }
+
+	// the search starts from `centre`. the noise table is built here, from its own stream so nobody else's draws move
+	void start(const NeuralNetwork& centre)
+	{
+		m_centre = centre;
+		m_started = true;
+		m_step.assign(parameters, 0.f);
+
+		// box muller, two gaussians from every two uniforms
+		CounterRng rng{ CounterRng::streamKey(RandomDist::runSeed.load(), RandomDist::Noise, 0, 0), 0 };
+		m_noise.resize(es_noise_table);
+		for (unsigned i = 0; i + 1 < es_noise_table; i += 2)
+		{
+			const float radius = std::sqrt(-2.f * std::log(1.f - rng.uniform01()));
+			const float angle = 6.2831853f * rng.uniform01();
+			m_noise[i] = radius * std::cos(angle);
+			m_noise[i + 1] = radius * std::sin(angle);
+		}
+	}
+
+	// the next generation start()s the search over, from a loaded checkpoint's best network (the centre it saved)
+	void restart() { m_started = false; }
+
+	// draws where every pair's noise starts this generation, from the calling thread's stream
+	void sample(const unsigned games)
+	{
+		m_offsets.resize(pairs(games));
+		for (unsigned& offset : m_offsets)
+			offset = RandomDist::randRange(0u, es_noise_table - parameters);
+	}
+
+	// the network game `game` plays: games 2k + 1 and 2k + 2 are pair k, plus and minus its noise, game 0 (and one
+	// left over when the pairs do not fill the games) plays the centre. different games can be set up at the same time
+	void perturb(const unsigned game, NeuralNetwork* network) const
+	{
+		*network = m_centre;
+		if (game == 0 || (game - 1) / 2 >= m_offsets.size())
+			return;
+
+		const float sign = (game - 1) % 2 == 0 ? 1.f : -1.f;
+		network->addScaled(&m_noise[m_offsets[(game - 1) / 2]], sign * es_noise_std);
+	}
+
+	// moves the centre using every pair's scores (lower is better) from the games set up by perturb() since sample()
+	void step(const std::vector<float>& scores)
+	{
+		const unsigned samples = 2 * static_cast<unsigned>(m_offsets.size());
+		if (samples < 2)
+			return;
+
+		// centred ranks: the best game gets +0.5, the worst -0.5, a tie goes to the lower game
+		std::vector<unsigned> order(samples);
+		std::iota(order.begin(), order.end(), 1u);
+		std::stable_sort(order.begin(), order.end(), [&](const unsigned a, const unsigned b) { return scores[a] < scores[b]; });
+
+		std::vector<float> utility(samples + 1, 0.f);
+		for (unsigned rank = 0; rank < samples; ++rank)
+			utility[order[rank]] = 0.5f - static_cast<float>(rank) / static_cast<float>(samples - 1);
+
+		std::fill(m_step.begin(), m_step.end(), 0.f);
+		for (unsigned pair = 0; pair < m_offsets.size(); ++pair)
+		{
+			const float weight = utility[2 * pair + 1] - utility[2 * pair + 2];
+			const float* noise = &m_noise[m_offsets[pair]];
+			for (unsigned i = 0; i < parameters; ++i)
+				m_step[i] += weight * noise[i];
+		}
+
+		for (float& parameter : m_centre.parameterSpan())
+			parameter *= 1.f - es_learning_rate * es_weight_decay;
+		m_centre.addScaled(m_step.data(), es_learning_rate / (static_cast<float>(samples) * es_noise_std));
+	}
+};
@@ -2,43 +2,217 @@
 
 #include "utility.hpp"
 #include "Agent.hpp"
+#include "NeuralNetwork.hpp"
 #include "settings.hpp"
 
+// what the renderer needs to know about one agent, copied out of the game so drawing never touches live state
+struct AgentSnapshot
+{
+	sf::Vector2f position;
+	sf::Vector2f velocity;
+	float score;
+	bool tagged;
+};
+
+
+struct GameSnapshot
+{
+	AgentSnapshot agents[GameSettings::agentsPergame];
+	int timeRemaining;
+	unsigned generation;
+};
+
+
 /* This is a Game which will exist as */
 class Game : GameSettings
 {
 public:
 	int timeRemaining = gameFrameLength;
-	std::vector<Agent> agents{};
-	NeuralNetwork networks[agentsPergame] = {};
+	int frameLength = gameFrameLength; // this episode's length, race rounds play shorter ones (see Simulation::runRace)
 
+	// the agents live in the store every game shares, this game is entry `index` of each slot
+	AgentStore* agents = nullptr;
+	unsigned index = 0;
 
-public:
-	Game() { agents.reserve(agentsPergame); }
+	// agent 0 learns with this game's own mutated network, every other agent plays the opponent every game shares,
+	// a read-only network from the league (see league.hpp)
+	NeuralNetwork learner{};
+	const NeuralNetwork* opponent = nullptr;
+	NeuralNetwork::Activations activations[agentsPergame] = {};
 
-	void initAgent(const Agent& agent) { agents.emplace_back(agent); }
+	// the networks run on every decisionInterval-th frame counted from decisionOffset, on the frames in between the
+	// agents keep steering by their last outputs. the first frame of a game always decides
+	unsigned decisionInterval = 1;
+	unsigned decisionOffset = 0;
 
-	void initiliseGame(const std::vector<sf::Vector2f>& starting_positions)
+	// with earlyTermination the game is checked every steadyWindow frames and ended once it has settled, see endIfSettled()
+	bool earlyTermination = false;
+	unsigned framesSkipped = 0; // frames this game did not play because it ended early
+	float extrapolationError = 0; // bound on how far the learner's extrapolated score can be off, if no one gets tagged again
+
+	struct SteadyState
+	{
+		unsigned calmWindows = 0;
+		int32_t tags = 0;         // tags in the game up to the start of the window
+		float learnerScore = 0;   // the learner's score at the start of the window
+		float speed = -1;         // the agents' mean speed over the last window, -1 before the first window is over
+		float gap = 0;            // the learner's distance to the nearest other agent at the start of the window
+		float minRate = 0, maxRate = 0; // the learner's score per frame over the calm windows
+		sf::Vector2f positions[agentsPergame] = {};
+	} steady{};
+
+
+public:
+	Game(AgentStore* store, const unsigned gameIndex) : agents(store), index(gameIndex) {}
+
+	void initiliseGame(const std::vector<sf::Vector2f>& starting_positions, const unsigned frames = gameFrameLength)
 	{
 		// other re-settings
-		timeRemaining = gameFrameLength;
+		frameLength = static_cast<int>(frames);
+		timeRemaining = frameLength;
+		framesSkipped = 0;
+		extrapolationError = 0;
+		steady = {};
+
+		agents->reset(index);
+
+		agents->tagged[agents->index(0, index)] = 1;
+		for (unsigned i = 0; i < agentsPergame; i++)
+			agents->setPosition(i, index, starting_positions[i]);
+	}
+
+	// sequential: the agents observe, think and move one after another, so agent 1 sees where agent 0 has just gone.
+	// simultaneous: every agent observes the same frame, then they all move and collide in one pass
+	bool tick(const bool simultaneous = false)
+	{
+		const bool decide = decides();
+		for (unsigned i = 0; i < agentsPergame; i++)
+		{
+			// computing the velocity from the neural network
+			if (decide)
+			{
+				agents->setNetworkInputs(i, index, activations[i].inputs.data());
+				network(i).compute_output(activations[i]);
+			}
+
+			if (!simultaneous)
+				agents->act(i, index, index + 1, activations[i].outputs.data(), 0);
+		}
+
+		if (simultaneous)
+		{
+			for (unsigned i = 0; i < agentsPergame; i++)
+				agents->integrate(i, index, index + 1, activations[i].outputs.data(), 0);
+			agents->resolve(index, index + 1);
+		}
+		return countDown();
+	}
+
+	[[nodiscard]] const NeuralNetwork& network(const unsigned agent) const { return agent == 0 ? learner : *opponent; }
+
+	// whether the networks run this frame
+	[[nodiscard]] bool decides() const
+	{
+		const unsigned frame = frameLength - timeRemaining;
+		return frame == 0 || (frame + decisionOffset) % decisionInterval == 0;
+	}
+
+	// ends the frame, true once the game is over
+	bool countDown()
+	{
+		if (--timeRemaining == 0)
+			return true;
+		return earlyTermination && endIfSettled();
+	}
+
+	[[nodiscard]] bool playing() const { return timeRemaining > 0; }
+	[[nodiscard]] unsigned framesPlayed() const { return static_cast<unsigned>(frameLength - timeRemaining) - framesSkipped; }
+
+	// the game plays no more frames until the next initiliseGame(), a candidate knocked out of a race sits out the rest
+	void sitOut()
+	{
+		frameLength = 0;
+		timeRemaining = 0;
+		framesSkipped = 0;
+	}
+
+	// at the end of every steadyWindow frames: the window was calm when nobody got tagged, the agents' mean speed
+	// (how far they got from where the window started) changed by at most maxSpeedChange of the last window's (so a
+	// slow drift that keeps picking up speed is not mistaken for a settled game) and the learner neither closed in on
+	// nor got away from its nearest agent by more than maxGapChange. without tags who is it cannot change and the
+	// learner's score only moves with the distances, so after steadyWindows calm windows in a row whose score rates
+	// spread so little that it would add up to at most maxExtrapolationError over the frames left, the game ends and
+	// the learner gets the last window's rate for every frame it skips.
+	// a slow drift is still a tag waiting to happen, so the game keeps going while the gap shrinking at the last
+	// window's pace would bring the learner and its nearest agent into touch before the game is over. the networks
+	// can still break out of a calm spell on their own, which no window can see coming, so this is a heuristic
+	bool endIfSettled()
+	{
+		if ((frameLength - timeRemaining) % steadyWindow != 0)
+			return false;
+
+		const unsigned learner = agents->index(0, index);
+		const float rate = (agents->score[learner] - steady.learnerScore) / steadyWindow;
+
+		int32_t tags = 0;
+		float speed = 0;
+		float gap = std::numeric_limits<float>::max();
+		for (unsigned i = 0; i < agentsPergame; i++)
+		{
+			const sf::Vector2f position = agents->position(i, index);
+			const sf::Vector2f windowStart = steady.speed < 0 ? agents->startPosition(i, index) : steady.positions[i];
+			speed += std::sqrt(distSquared(position, windowStart));
+			steady.positions[i] = position;
+
+			tags += agents->timesTagged[agents->index(i, index)];
+			if (i != 0)
+				gap = std::min(gap, std::sqrt(distSquared(position, agents->position(0, index))));
+		}
+		speed /= agentsPergame * steadyWindow;
+
+		const bool calm = steady.speed >= 0 && tags == steady.tags && std::abs(gap - steady.gap) <= maxGapChange
+			&& std::abs(speed - steady.speed) <= steady.speed * maxSpeedChange + minSpeedChange;
+		if (calm)
+		{
+			steady.calmWindows++;
+			steady.minRate = std::min(steady.minRate, rate);
+			steady.maxRate = std::max(steady.maxRate, rate);
+		}
+		else
+		{
+			steady.calmWindows = 0;
+			steady.minRate = rate;
+			steady.maxRate = rate;
+		}
+
+		steady.tags = tags;
+		steady.learnerScore = agents->score[learner];
+		steady.speed = speed;
+
+		const float closing = std::max(steady.gap - gap, 0.f) / steadyWindow;
+		const bool touchAhead = gap - closing * static_cast<float>(timeRemaining) <= AgentSettings::radius * 2;
 
-		for (unsigned agent = 0; agent < agentsPergame; agent++)
+		const float error = (steady.maxRate - steady.minRate) * static_cast<float>(timeRemaining);
+		if (steady.calmWindows < steadyWindows || error > maxExtrapolationError || touchAhead)
 		{
-			agents[agent].reset();
+			steady.gap = gap;
+			return false;
 		}
 
-		agents[0].tagged = true;
-		agents[0].position = starting_positions[0];
-		agents[1].position = starting_positions[1];
+		agents->score[learner] += rate * static_cast<float>(timeRemaining);
+		extrapolationError = error;
+		framesSkipped = timeRemaining;
+		timeRemaining = 0;
+		return true;
 	}
 
-	bool tick()
+	void takeSnapshot(GameSnapshot& snapshot) const
 	{
 		for (unsigned i = 0; i < agentsPergame; i++)
 		{
-			agents[i].update(networks[i], agents);
+			const unsigned agent = agents->index(i, index);
+			snapshot.agents[i] = { agents->position(i, index), agents->velocity(i, index), agents->score[agent], agents->tagged[agent] != 0 };
 		}
-		return --timeRemaining == 0;
+		snapshot.timeRemaining = timeRemaining;
 	}
 };
\ No newline at end of file
@@ -0,0 +1,11 @@
+#include "simulation/simulation.hpp"
+
+// entry point of the headless build (compiled with HEADLESS defined), trains without a window so it can run on
+// display-less servers. only the sfml headers are needed, nothing from sfml-graphics or sfml-window is linked. the
+// options are the window's too, see simulation/options.cpp
+
+
+int main(const int argc, char* argv[])
+{
+	return Simulation::fromArguments(argc, argv);
+}
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "utility.hpp"
+#include "NeuralNetwork.hpp"
+#include "snapshot_archive.hpp"
+
+
+// the opponents the learner trains against: a snapshot of the best network every snapshot frequency generations, all
+// of them kept for good. every snapshot and the learner carry an elo rating that is moved game by game by who scored
+// lower (lower is better for everyone). a new snapshot starts at the learner's rating, it is the learner as it was.
+// every swap_steps generations a new opponent is picked: the latest snapshot with probability play_latest_ratio (plain
+// self play), otherwise one drawn by prioritised fictitious self play, weighted by (1 - p)^power where p is the
+// learner's expected score against it. the snapshots the learner still loses to get most of the games and the ones it
+// beats every time next to none.
+// only the index (ratings and when each joined) is held in memory, the networks live in the SnapshotArchive and the
+// one picked is copied out of it, so a league of tens of thousands costs a few bytes a snapshot
+class League
+{
+public:
+	static constexpr uint16_t snapshot_frequency = 250; // how often (generations) the best network joins the league
+	static constexpr uint16_t swap_steps = 5;           // how often the network the learning agent plays against changes
+	static constexpr float    play_latest_ratio = 0.5f; // chance of playing the latest snapshot instead of a pfsp draw
+	static constexpr float    pfsp_power = 2.f;         // 0 draws every snapshot alike
+	static constexpr float    elo_k = 2.f;              // rating points moved per game
+	static constexpr float    initial_rating = 1000.f;
+	static constexpr float    easy_score = 0.9f;        // a game the learner was expected to score this much of is an easy win
+
+	// network i of the archive
+	struct Snapshot
+	{
+		float rating = initial_rating;
+		unsigned games = 0;      // games the learner played against it
+		unsigned generation = 0; // when it joined
+		float score = 0;         // the generation's best score when it joined
+	};
+
+
+private:
+	static constexpr unsigned none = ~0u;
+
+	std::vector<Snapshot> m_snapshots{};
+	SnapshotArchive m_archive{};
+	NeuralNetwork m_opponentNetwork{}; // the current opponent, copied out of the archive when it was picked
+	unsigned m_loaded = none;          // which snapshot m_opponentNetwork holds
+	unsigned m_latest = 0;
+	unsigned m_opponent = 0;
+	unsigned m_next = none; // drawn by opponentChanges() ahead of opponent()
+	bool m_picked = false;
+	float m_learnerRating = initial_rating;
+
+	unsigned m_snapshotFrequency = snapshot_frequency;
+	float m_pfspPower = pfsp_power;
+
+	unsigned long long m_games = 0;
+	unsigned long long m_easyGames = 0;
+
+	std::vector<unsigned> m_changed{}; // snapshots whose index entry changed since takeChanged(), each once
+	std::vector<uint8_t> m_isChanged{};
+
+	void touch(const unsigned i)
+	{
+		if (i >= m_isChanged.size())
+			m_isChanged.resize(i + 1, 0);
+		if (m_isChanged[i] == 0)
+		{
+			m_isChanged[i] = 1;
+			m_changed.push_back(i);
+		}
+	}
+
+	// false when the archive could not take the network, the league is then left as it was
+	bool insert(const NeuralNetwork& network, const Snapshot& snapshot)
+	{
+		if (!m_archive.append(network, snapshot.generation, snapshot.score))
+			return false;
+		m_latest = static_cast<unsigned>(m_snapshots.size());
+		m_snapshots.push_back(snapshot);
+		touch(m_latest);
+		return true;
+	}
+
+	// the next opponent: the latest snapshot or a pfsp draw
+	[[nodiscard]] unsigned draw() const
+	{
+		const bool latest = RandomDist::rand01float() < play_latest_ratio;
+		return latest || m_snapshots.size() == 1 ? m_latest : prioritised();
+	}
+
+	// the draw prioritised fictitious self play makes, from the calling thread's stream
+	[[nodiscard]] unsigned prioritised() const
+	{
+		std::vector<float> weights(m_snapshots.size());
+		for (unsigned i = 0; i < m_snapshots.size(); ++i)
+			weights[i] = std::pow(1.f - expectedScore(i), m_pfspPower);
+
+		float total = 0;
+		for (const float weight : weights)
+			total += weight;
+		if (total <= 0.f)
+			return RandomDist::randRange(0u, static_cast<unsigned>(m_snapshots.size()) - 1);
+
+		float draw = RandomDist::rand01float() * total;
+		for (unsigned i = 0; i < weights.size(); ++i)
+		{
+			draw -= weights[i];
+			if (draw < 0.f)
+				return i;
+		}
+		return static_cast<unsigned>(weights.size()) - 1;
+	}
+
+
+public:
+	// the league starts with one random network (networks draw their weights when they are made, so the copy out of
+	// the archive is the one that is made random)
+	League()
+	{
+		insert(m_opponentNetwork, {});
+		m_loaded = 0;
+	}
+
+	// `network` (that scored `score`) joins the league when `generation` is a snapshot generation, returns whether it did
+	bool add(const NeuralNetwork& network, const unsigned generation, const float score)
+	{
+		if (generation % m_snapshotFrequency != 0)
+			return false;
+
+		if (!insert(network, { m_learnerRating, 0, generation, score }))
+		{
+			std::cerr << "[error]: the snapshot archive could not take the network of generation " << generation << ", the league goes on without it\n";
+			return false;
+		}
+		std::cout << "[Notice]: Adding Neural Network \n";
+		return true;
+	}
+
+	// the network the learner plays from `generation` on, a new one is picked every swap_steps generations
+	const NeuralNetwork* opponent(const unsigned generation)
+	{
+		if (!m_picked || generation % swap_steps == 0)
+		{
+			m_opponent = m_next != none ? m_next : draw();
+			m_next = none;
+			m_picked = true;
+		}
+
+		if (m_loaded != m_opponent)
+		{
+			m_archive.load(m_opponent, &m_opponentNetwork);
+			m_loaded = m_opponent;
+		}
+		return &m_opponentNetwork;
+	}
+
+	// whether opponent(`generation`) would hand out a different network than the one being played. the pick is drawn
+	// here and kept for opponent(), a pick of the same snapshot is dropped
+	bool opponentChanges(const unsigned generation)
+	{
+		if (m_picked && generation % swap_steps != 0)
+			return false;
+		if (m_next == none)
+			m_next = draw();
+		if (m_picked && m_next == m_opponent)
+		{
+			m_next = none;
+			return false;
+		}
+		return true;
+	}
+
+	// the learner's expected score against snapshot `i`, 1 is a sure win
+	[[nodiscard]] float expectedScore(const unsigned i) const
+	{
+		return 1.f / (1.f + std::pow(10.f, (m_snapshots[i].rating - m_learnerRating) / 400.f));
+	}
+
+	// one game of the learner against the current opponent: `score` is 1 for a win, 0.5 for a draw and 0 for a loss
+	void record(const float score)
+	{
+		Snapshot& opponent = m_snapshots[m_opponent];
+		const float expected = expectedScore(m_opponent);
+		m_learnerRating += elo_k * (score - expected);
+		opponent.rating -= elo_k * (score - expected);
+		opponent.games++;
+		touch(m_opponent);
+
+		m_games++;
+		m_easyGames += expected >= easy_score;
+	}
+
+	// replaces every snapshot with the saved `networks` and their `index` entries, kept in memory until the next save
+	// archives them. the last one counts as the latest until setLatest() says otherwise. the archive file is let go
+	// of, not emptied, a checkpoint may still name it. false, with the league left as it was, when there are none or
+	// they do not match: the league is never empty
+	bool replace(const std::vector<NeuralNetwork>& networks, const std::vector<Snapshot>& index)
+	{
+		if (networks.empty() || networks.size() != index.size())
+		{
+			std::cerr << "[error]: a saved league needs at least one network and an index entry for each, it has " << networks.size() << " and " << index.size() << "\n";
+			return false;
+		}
+
+		SnapshotArchive archive{};
+		for (unsigned i = 0; i < networks.size(); ++i)
+			if (!archive.append(networks[i], index[i].generation, index[i].score))
+				return false;
+
+		takeChanged();
+		m_archive = std::move(archive);
+		m_snapshots = index;
+		m_loaded = none;
+		m_latest = size() - 1;
+		m_opponent = 0;
+		m_next = none;
+		m_picked = false;
+		m_learnerRating = initial_rating;
+		for (unsigned i = 0; i < size(); ++i)
+			touch(i);
+		return true;
+	}
+
+	// from now on the networks are kept in the archive file at `path`, started over with the ones the league has
+	bool archiveTo(const std::string& path)
+	{
+		return m_archive.open(path, false);
+	}
+
+	// picks up the league a save left: the archive file at `path` and the index that was saved with it. the archive
+	// may have grown since, whatever it holds past the index is dropped
+	bool resume(const std::string& path, const std::vector<Snapshot>& index)
+	{
+		SnapshotArchive archive{};
+		if (!archive.open(path, true))
+			return false;
+		if (archive.size() < index.size() || index.empty())
+		{
+			std::cerr << "[error]: the snapshot archive " << path << " holds " << archive.size() << " networks, the save needs " << index.size() << "\n";
+			return false;
+		}
+
+		archive.truncate(static_cast<unsigned>(index.size()));
+		m_archive = std::move(archive);
+		m_snapshots = index;
+		m_loaded = none;
+		m_latest = size() - 1;
+		m_opponent = 0;
+		m_next = none;
+		m_picked = false;
+		takeChanged();
+		return true;
+	}
+
+	// the snapshots added or rated since the last call, for saving only what changed (see CheckpointDelta)
+	std::vector<unsigned> takeChanged()
+	{
+		for (const unsigned i : m_changed)
+			m_isChanged[i] = 0;
+		return std::exchange(m_changed, {});
+	}
+
+	void setLatest(const unsigned i) { m_latest = std::min(i, size() - 1); } // never empty, see replace() and resume()
+
+	void setLearnerRating(const float rating) { m_learnerRating = rating; }
+	void setSnapshotFrequency(const unsigned frequency) { m_snapshotFrequency = std::max(frequency, 1u); }
+	void setPfspPower(const float power) { m_pfspPower = power; }
+
+	[[nodiscard]] unsigned snapshotFrequency() const { return m_snapshotFrequency; }
+	[[nodiscard]] const std::vector<Snapshot>& snapshots() const { return m_snapshots; }
+	[[nodiscard]] const SnapshotArchive& archive() const { return m_archive; }
+	[[nodiscard]] unsigned size() const { return static_cast<unsigned>(m_snapshots.size()); }
+	[[nodiscard]] unsigned latest() const { return m_latest; }
+	[[nodiscard]] float learnerRating() const { return m_learnerRating; }
+	[[nodiscard]] const Snapshot& currentOpponent() const { return m_snapshots[m_opponent]; }
+
+	// a copy of snapshot i's network
+	[[nodiscard]] NeuralNetwork network(const unsigned i) const
+	{
+		NeuralNetwork network{ m_opponentNetwork };
+		m_archive.load(i, &network);
+		return network;
+	}
+
+	// the share of every game so far the learner was expected to win at least easy_score of
+	[[nodiscard]] double easyShare() const { return m_games == 0 ? 0.0 : static_cast<double>(m_easyGames) / static_cast<double>(m_games); }
+};
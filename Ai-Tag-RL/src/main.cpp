@@ -1,15 +1,13 @@
 #include "simulation/simulation.hpp"
 
 // TODO:
-// - multi-threading
 // - graphing
 // - separeate container for scores?
 // - test that the RL works
 
-// TODO: since all of the training neurons you can make a pointer for agents[1]. halfing the amount of memory used
 
-
-int main()
+// the options are the headless build's, see simulation/options.cpp
+int main(const int argc, char* argv[])
 {
-	Simulation().run();
+	return Simulation::fromArguments(argc, argv);
 }
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+// a whole file mapped into memory, the one place that knows mmap from CreateFileMapping. Read maps it read only,
+// Keep and Create map it for writing, Create starts the file over. resize() sets the file's length and maps it
+// again, pointers into the old mapping do not survive it
+class MappedFile
+{
+public:
+	enum Mode : uint8_t { Read, Keep, Create };
+
+
+private:
+	char* m_data = nullptr;
+	size_t m_size = 0;
+	Mode m_mode = Read;
+
+#ifdef _WIN32
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+#else
+	int m_file = -1;
+#endif
+
+	bool map(const size_t bytes)
+	{
+		unmap();
+		if (bytes == 0)
+			return true;
+
+#ifdef _WIN32
+		LARGE_INTEGER size{};
+		size.QuadPart = static_cast<LONGLONG>(bytes);
+		m_mapping = CreateFileMappingA(m_file, nullptr, m_mode == Read ? PAGE_READONLY : PAGE_READWRITE, static_cast<DWORD>(size.HighPart), size.LowPart, nullptr);
+		if (m_mapping == nullptr)
+			return false;
+		m_data = static_cast<char*>(MapViewOfFile(m_mapping, m_mode == Read ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS, 0, 0, bytes));
+#else
+		void* data = mmap(nullptr, bytes, m_mode == Read ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+		m_data = data == MAP_FAILED ? nullptr : static_cast<char*>(data);
+#endif
+
+		if (m_data == nullptr)
+			return false;
+		m_size = bytes;
+		return true;
+	}
+
+	void unmap()
+	{
+#ifdef _WIN32
+		if (m_data != nullptr)
+			UnmapViewOfFile(m_data);
+		if (m_mapping != nullptr)
+			CloseHandle(m_mapping);
+		m_mapping = nullptr;
+#else
+		if (m_data != nullptr)
+			munmap(m_data, m_size);
+#endif
+		m_data = nullptr;
+		m_size = 0;
+	}
+
+	[[nodiscard]] uint64_t fileSize() const
+	{
+#ifdef _WIN32
+		LARGE_INTEGER size{};
+		return GetFileSizeEx(m_file, &size) ? static_cast<uint64_t>(size.QuadPart) : 0;
+#else
+		struct stat status {};
+		return fstat(m_file, &status) == 0 ? static_cast<uint64_t>(status.st_size) : 0;
+#endif
+	}
+
+
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept { swap(other); }
+	MappedFile& operator=(MappedFile&& other) noexcept { swap(other); return *this; }
+	~MappedFile() { close(); }
+
+	void swap(MappedFile& other) noexcept
+	{
+		std::swap(m_data, other.m_data);
+		std::swap(m_size, other.m_size);
+		std::swap(m_mode, other.m_mode);
+		std::swap(m_file, other.m_file);
+#ifdef _WIN32
+		std::swap(m_mapping, other.m_mapping);
+#endif
+	}
+
+	// opens (Keep and Create make it if it is missing) and maps the whole file as it is
+	bool open(const std::string& path, const Mode mode)
+	{
+		close();
+		m_mode = mode;
+
+#ifdef _WIN32
+		const DWORD access = mode == Read ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE;
+		const DWORD disposition = mode == Read ? OPEN_EXISTING : mode == Keep ? OPEN_ALWAYS : CREATE_ALWAYS;
+		m_file = CreateFileA(path.c_str(), access, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, disposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE)
+			return false;
+#else
+		const int flags = mode == Read ? O_RDONLY : mode == Keep ? O_RDWR | O_CREAT : O_RDWR | O_CREAT | O_TRUNC;
+		m_file = ::open(path.c_str(), flags, 0644);
+		if (m_file == -1)
+			return false;
+#endif
+
+		if (map(fileSize()))
+			return true;
+		close();
+		return false;
+	}
+
+	// the file becomes `bytes` long, new bytes read as zero
+	bool resize(const size_t bytes)
+	{
+		if (m_mode == Read)
+			return false;
+
+#ifdef _WIN32
+		unmap(); // the mapping object sets the length, it can only grow the file
+		LARGE_INTEGER size{};
+		size.QuadPart = static_cast<LONGLONG>(bytes);
+		if (!SetFilePointerEx(m_file, size, nullptr, FILE_BEGIN) || !SetEndOfFile(m_file))
+			return false;
+#else
+		unmap();
+		if (ftruncate(m_file, static_cast<off_t>(bytes)) != 0)
+			return false;
+#endif
+		return map(bytes);
+	}
+
+	void close()
+	{
+		unmap();
+#ifdef _WIN32
+		if (m_file != INVALID_HANDLE_VALUE)
+			CloseHandle(m_file);
+		m_file = INVALID_HANDLE_VALUE;
+#else
+		if (m_file != -1)
+			::close(m_file);
+		m_file = -1;
+#endif
+	}
+
+	// the pages will be wanted in no particular order, reading ahead of one only pulls in ones nobody asked for
+	void adviseRandom() const
+	{
+#ifndef _WIN32
+		if (m_data != nullptr)
+			madvise(m_data, m_size, MADV_RANDOM);
+#endif
+	}
+
+	// hands the written pages to the os to write back, without waiting for it
+	void flush() const
+	{
+		if (m_data == nullptr || m_mode == Read)
+			return;
+#ifdef _WIN32
+		FlushViewOfFile(m_data, 0);
+#else
+		msync(m_data, m_size, MS_ASYNC);
+#endif
+	}
+
+	// waits until everything written to the file at `path` so far, through any mapping of it, is on disk. the file is
+	// opened and mapped again here, it is meant for one another MappedFile writes to and may map again while this runs
+	static bool sync(const std::string& path)
+	{
+#ifdef _WIN32
+		const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		bool ok = true;
+		const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping != nullptr)
+		{
+			void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			ok = view != nullptr && FlushViewOfFile(view, 0);
+			if (view != nullptr)
+				UnmapViewOfFile(view);
+			CloseHandle(mapping);
+		}
+		ok = ok && FlushFileBuffers(file);
+		CloseHandle(file);
+		return ok;
+#else
+		const int file = ::open(path.c_str(), O_RDONLY);
+		if (file == -1)
+			return false;
+
+		bool ok = true;
+		struct stat status {};
+		if (fstat(file, &status) == 0 && status.st_size > 0)
+		{
+			const size_t bytes = static_cast<size_t>(status.st_size);
+			void* data = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, file, 0);
+			ok = data != MAP_FAILED && msync(data, bytes, MS_SYNC) == 0;
+			if (data != MAP_FAILED)
+				munmap(data, bytes);
+		}
+		ok = ok && fsync(file) == 0;
+		::close(file);
+		return ok;
+#endif
+	}
+
+	[[nodiscard]] bool isOpen() const { return m_data != nullptr; }
+	[[nodiscard]] char* data() const { return m_data; }
+	[[nodiscard]] size_t size() const { return m_size; }
+};
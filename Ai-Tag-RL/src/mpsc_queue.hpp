@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+
+// a bounded, lock-free queue any number of threads push to and one thread pops from (the steady state evolution's
+// game results). every cell carries a sequence number: a producer claims a position by moving `m_tail` on with a CAS,
+// writes its cell and then publishes it by bumping the cell's sequence, the consumer only reads a cell once its
+// sequence says it is complete, so a slow producer never exposes a half written value. nobody ever waits on a lock,
+// a push into a full queue fails instead of blocking
+template<class T>
+class MpscQueue
+{
+	static_assert(std::is_trivially_copyable_v<T>, "values are copied in and out of the cells");
+
+	struct Cell
+	{
+		std::atomic<size_t> sequence = 0;
+		T value{};
+	};
+
+	std::unique_ptr<Cell[]> m_cells{};
+	size_t m_mask = 0;
+
+	alignas(64) std::atomic<size_t> m_tail = 0; // next position a producer claims
+	alignas(64) size_t m_head = 0;              // next position the consumer reads, only it touches this
+
+
+public:
+	// room for at least `capacity` values
+	explicit MpscQueue(const size_t capacity)
+	{
+		const size_t cells = std::bit_ceil(capacity < 2 ? size_t{ 2 } : capacity);
+		m_cells = std::make_unique<Cell[]>(cells);
+		m_mask = cells - 1;
+		for (size_t i = 0; i < cells; ++i)
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+
+	// any thread. false when the queue is full
+	bool push(const T& value)
+	{
+		size_t position = m_tail.load(std::memory_order_relaxed);
+		Cell* cell = nullptr;
+		while (true)
+		{
+			cell = &m_cells[position & m_mask];
+			const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			const auto lead = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+			// the cell is free for this position, try to claim it. on failure `position` holds the new tail
+			if (lead == 0)
+			{
+				if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (lead < 0)
+				return false; // the consumer has not read this cell since the last lap
+			else
+				position = m_tail.load(std::memory_order_relaxed);
+		}
+
+		cell->value = value;
+		cell->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	// the consumer thread only. false when nothing is waiting
+	bool pop(T& value)
+	{
+		Cell& cell = m_cells[m_head & m_mask];
+		if (cell.sequence.load(std::memory_order_acquire) != m_head + 1)
+			return false;
+
+		value = cell.value;
+		cell.sequence.store(m_head + m_mask + 1, std::memory_order_release); // free for the producers' next lap
+		++m_head;
+		return true;
+	}
+};
@@ -0,0 +1,481 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include "settings.hpp"
+#include "utility.hpp"
+#include "NeuralNetwork.hpp"
+#include "thread_pool.hpp"
+
+
+// the training side of a DenseNetwork, over a block of up to `rows` samples at a time. forward() runs the block through
+// the same shared weight kernel BatchedInference uses (so every sample gets exactly what compute_output() gives) and
+// keeps every layer's outputs, backward() turns the loss gradient of the outputs into the gradient of every parameter,
+// added to `gradient` which is laid out like the network's parameters. every layer is tanh(2x) like compute_output(),
+// with LinearOutput the last one is left linear (a value estimate is not bounded). the backward loops all run over
+// zero padded rows, so the compiler vectorises them and the padding only ever gets zeros
+template <class Network, bool LinearOutput = false>
+struct Backprop
+{
+	static constexpr unsigned rows = 64;
+	static constexpr unsigned weightLayers = Network::weightLayers;
+
+	static constexpr unsigned width(const unsigned layer) { return Simd::padded(Network::dims[layer]); }
+
+	// row r of layer l starts at layer[l] + r * width(l), layer 0 holds the inputs (whose padding has to stay zero)
+	struct Block
+	{
+		alignas(32) std::array<float, rows * Network::widestLayer> layer[Network::layerCount] = {};
+
+		float* inputs(const unsigned row) { return layer[0].data() + row * width(0); }
+		[[nodiscard]] const float* outputs(const unsigned row) const { return layer[weightLayers].data() + row * width(weightLayers); }
+	};
+
+	static void forward(const Network& network, Block& block, const unsigned count)
+	{
+		for (unsigned layer = 0; layer < weightLayers; ++layer)
+		{
+			const float* in = block.layer[layer].data();
+			float* out = block.layer[layer + 1].data();
+			if (!LinearOutput || layer + 1 < weightLayers)
+			{
+				Simd::denseTanhShared(network.layerWeights(layer), Network::rowStride(layer), network.layerBiases(layer), in, width(layer), out, Network::dims[layer + 1], count);
+				continue;
+			}
+
+			for (unsigned row = 0; row < count; ++row)
+			{
+				for (unsigned node = 0; node < Network::dims[layer + 1]; ++node)
+				{
+					const float* weights = network.layerWeights(layer) + node * Network::rowStride(layer);
+					float sum = network.layerBiases(layer)[node];
+					for (unsigned input = 0; input < width(layer); ++input)
+						sum += weights[input] * in[row * width(layer) + input];
+					out[row * width(layer + 1) + node] = sum;
+				}
+			}
+		}
+	}
+
+	// `block` as forward() left it, `outputGradient` the loss gradient of every output of the block's rows, row r at
+	// outputGradient + r * width(weightLayers) with zeros in the padding
+	static void backward(const Network& network, const Block& block, const unsigned count, const float* outputGradient, float* gradient)
+	{
+		alignas(32) std::array<float, rows * Network::widestLayer> delta, below;
+		std::copy_n(outputGradient, count * width(weightLayers), delta.data());
+
+		for (unsigned layer = weightLayers; layer-- > 0;)
+		{
+			const unsigned inWidth = width(layer), outWidth = width(layer + 1), nodes = Network::dims[layer + 1];
+			const float* in = block.layer[layer].data();
+			const float* out = block.layer[layer + 1].data();
+			float* weights = gradient + Network::weightOffset(layer);
+			float* biases = gradient + Network::weightCount + Network::biasOffset(layer);
+
+			// d tanh(2x) / dx = 2 (1 - tanh(2x)^2)
+			if (!LinearOutput || layer + 1 < weightLayers)
+			{
+				for (unsigned i = 0; i < count * outWidth; ++i)
+					delta[i] *= 2.f * (1.f - out[i] * out[i]);
+			}
+
+			for (unsigned row = 0; row < count; ++row)
+			{
+				const float* d = delta.data() + row * outWidth;
+				const float* x = in + row * inWidth;
+				for (unsigned node = 0; node < nodes; ++node)
+				{
+					biases[node] += d[node];
+					float* weightRow = weights + node * inWidth;
+					for (unsigned input = 0; input < inWidth; ++input)
+						weightRow[input] += d[node] * x[input];
+				}
+			}
+
+			if (layer == 0)
+				break;
+
+			std::fill_n(below.data(), count * inWidth, 0.f);
+			for (unsigned row = 0; row < count; ++row)
+			{
+				const float* d = delta.data() + row * outWidth;
+				float* b = below.data() + row * inWidth;
+				for (unsigned node = 0; node < nodes; ++node)
+				{
+					const float* weightRow = network.layerWeights(layer) + node * inWidth;
+					for (unsigned input = 0; input < inWidth; ++input)
+						b[input] += d[node] * weightRow[input];
+				}
+			}
+			std::swap(delta, below);
+		}
+	}
+};
+
+
+// adam over a flat block of parameters. a parameter whose gradient is always zero (the padding) never moves
+template <unsigned Size>
+struct Adam
+{
+	static constexpr float beta1 = 0.9f, beta2 = 0.999f, epsilon = 1e-8f;
+
+	std::array<float, Size> m{}, v{};
+	unsigned steps = 0;
+
+	void step(float* parameters, const float* gradient, const float rate)
+	{
+		++steps;
+		const float correction1 = 1.f - std::pow(beta1, static_cast<float>(steps));
+		const float correction2 = 1.f - std::pow(beta2, static_cast<float>(steps));
+		for (unsigned i = 0; i < Size; ++i)
+		{
+			m[i] = beta1 * m[i] + (1.f - beta1) * gradient[i];
+			v[i] = beta2 * v[i] + (1.f - beta2) * gradient[i] * gradient[i];
+			parameters[i] -= rate * (m[i] / correction1) / (std::sqrt(v[i] / correction2) + epsilon);
+		}
+	}
+};
+
+
+// proximal policy optimisation. one policy plays the learner of every game: the network's outputs are the mean of a
+// gaussian over the two steering outputs, with one learned standard deviation per output that does not depend on
+// what the agent sees. every decision's observation, sampled steering and log probability, and the reward up to the
+// next decision (minus what the learner scored, lower scores being better), are recorded per game. once every game is
+// over a separate value network estimates every decision, generalised advantage estimation runs back over each game,
+// then a few epochs of shuffled minibatches take clipped surrogate steps on the policy and squared error steps on the
+// value network. a minibatch is split over the workers in blocks of Backprop::rows decisions, every worker adds into
+// its own gradient and the workers' gradients are summed.
+// the network the rest of the simulation sees (the opponent pool, saving, evaluation) is the policy's mean
+class ProximalPolicyOptimisation : NetSettings
+{
+public:
+	static constexpr unsigned observations = NN_dims[0];
+	static constexpr unsigned actions = NN_dims[NetworkLayers - 1];
+
+	using ValueNetwork = DenseNetworkFromDims<ppo_value_dims>::type;
+
+
+private:
+	using PolicyPass = Backprop<NeuralNetwork>;
+	using ValuePass = Backprop<ValueNetwork, true>;
+
+	static constexpr unsigned policyParameters = NeuralNetwork::parameterCount;
+	static constexpr unsigned valueParameters = ValueNetwork::parameterCount;
+	static constexpr unsigned blockRows = PolicyPass::rows;
+	static constexpr unsigned meanWidth = PolicyPass::width(NetworkLayers - 1);
+	static constexpr unsigned valueWidth = ValuePass::width(ValueNetwork::weightLayers);
+
+	// one worker's gradient and scratch space
+	struct Worker
+	{
+		alignas(32) std::array<float, policyParameters> policy{};
+		alignas(32) std::array<float, valueParameters> value{};
+		std::array<float, actions> logStd{};
+
+		PolicyPass::Block policyBlock{};
+		ValuePass::Block valueBlock{};
+		alignas(32) std::array<float, blockRows * meanWidth> meanGradient{};
+		alignas(32) std::array<float, blockRows * valueWidth> valueGradient{};
+
+		void clear()
+		{
+			policy.fill(0.f);
+			value.fill(0.f);
+			logStd.fill(0.f);
+		}
+	};
+
+	NeuralNetwork m_policy{};
+	ValueNetwork m_value{};
+	std::array<float, actions> m_logStd{};
+	Adam<policyParameters> m_policyAdam{};
+	Adam<valueParameters> m_valueAdam{};
+	Adam<actions> m_logStdAdam{};
+	bool m_started = false;
+
+	// the rollout, game g's decisions are entries [g * m_capacity, g * m_capacity + m_steps[g])
+	unsigned m_capacity = 0;
+	std::vector<unsigned> m_steps{};
+	std::vector<float> m_observations{}; // [entry][observation]
+	std::vector<float> m_actions{};      // [entry][action], as sampled, before the agent clamps it
+	std::vector<float> m_logProbability{};
+	std::vector<float> m_values{};
+	std::vector<float> m_rewards{};
+	std::vector<float> m_advantages{};
+	std::vector<float> m_returns{};
+	std::vector<float> m_finalObservations{}; // [game][observation], where the game was when its time ran out
+	std::vector<float> m_finalValues{};
+
+	std::vector<unsigned> m_samples{};
+	std::vector<Worker> m_workers{};
+
+	[[nodiscard]] float logProbability(const float* mean, const float* action) const
+	{
+		float log = 0;
+		for (unsigned i = 0; i < actions; ++i)
+		{
+			const float z = (action[i] - mean[i]) * std::exp(-m_logStd[i]);
+			log -= 0.5f * z * z + m_logStd[i];
+		}
+		return log;
+	}
+
+	// the value network's estimate of the entries samples[first, last)
+	void estimate(const unsigned first, const unsigned last, Worker& worker)
+	{
+		for (unsigned begin = first; begin < last; begin += blockRows)
+		{
+			const unsigned count = std::min(blockRows, last - begin);
+			for (unsigned row = 0; row < count; ++row)
+				std::copy_n(&m_observations[static_cast<size_t>(m_samples[begin + row]) * observations], observations, worker.valueBlock.inputs(row));
+
+			ValuePass::forward(m_value, worker.valueBlock, count);
+			for (unsigned row = 0; row < count; ++row)
+				m_values[m_samples[begin + row]] = worker.valueBlock.outputs(row)[0];
+		}
+	}
+
+	// the value network's estimate of where every game was left, on the calling thread
+	void estimateFinal(Worker& worker)
+	{
+		const auto games = static_cast<unsigned>(m_steps.size());
+		for (unsigned begin = 0; begin < games; begin += blockRows)
+		{
+			const unsigned count = std::min(blockRows, games - begin);
+			for (unsigned row = 0; row < count; ++row)
+				std::copy_n(&m_finalObservations[static_cast<size_t>(begin + row) * observations], observations, worker.valueBlock.inputs(row));
+
+			ValuePass::forward(m_value, worker.valueBlock, count);
+			for (unsigned row = 0; row < count; ++row)
+				m_finalValues[begin + row] = worker.valueBlock.outputs(row)[0];
+		}
+	}
+
+	// adds the gradients of the entries samples[first, last) to the worker's
+	void accumulate(const unsigned first, const unsigned last, Worker& worker) const
+	{
+		for (unsigned begin = first; begin < last; begin += blockRows)
+		{
+			const unsigned count = std::min(blockRows, last - begin);
+			for (unsigned row = 0; row < count; ++row)
+			{
+				const float* observation = &m_observations[static_cast<size_t>(m_samples[begin + row]) * observations];
+				std::copy_n(observation, observations, worker.policyBlock.inputs(row));
+				std::copy_n(observation, observations, worker.valueBlock.inputs(row));
+			}
+			PolicyPass::forward(m_policy, worker.policyBlock, count);
+			ValuePass::forward(m_value, worker.valueBlock, count);
+
+			for (unsigned row = 0; row < count; ++row)
+			{
+				const unsigned entry = m_samples[begin + row];
+				const float* mean = worker.policyBlock.outputs(row);
+				const float* action = &m_actions[static_cast<size_t>(entry) * actions];
+				float* meanGradient = &worker.meanGradient[row * meanWidth];
+
+				// the clipped surrogate has no gradient once the ratio is past the clip on the side the advantage pushes it
+				const float advantage = m_advantages[entry];
+				const float ratio = std::exp(logProbability(mean, action) - m_logProbability[entry]);
+				const bool clipped = (advantage > 0 && ratio > 1.f + ppo_clip) || (advantage < 0 && ratio < 1.f - ppo_clip);
+
+				for (unsigned i = 0; i < actions; ++i)
+				{
+					const float inverseVariance = std::exp(-2.f * m_logStd[i]);
+					const float difference = action[i] - mean[i];
+					meanGradient[i] = clipped ? 0.f : -advantage * ratio * difference * inverseVariance;
+					if (!clipped)
+						worker.logStd[i] -= advantage * ratio * (difference * difference * inverseVariance - 1.f);
+					worker.logStd[i] -= ppo_entropy; // the entropy of a gaussian grows with log sigma
+				}
+
+				worker.valueGradient[row * valueWidth] = worker.valueBlock.outputs(row)[0] - m_returns[entry];
+			}
+
+			PolicyPass::backward(m_policy, worker.policyBlock, count, worker.meanGradient.data(), worker.policy.data());
+			ValuePass::backward(m_value, worker.valueBlock, count, worker.valueGradient.data(), worker.value.data());
+		}
+	}
+
+	// scales the gradient down to at most ppo_max_gradient long
+	template <size_t Size>
+	static void clipNorm(std::array<float, Size>& gradient)
+	{
+		const float norm = std::sqrt(std::inner_product(gradient.begin(), gradient.end(), gradient.begin(), 0.f));
+		if (norm > ppo_max_gradient)
+		{
+			for (float& value : gradient)
+				value *= ppo_max_gradient / norm;
+		}
+	}
+
+
+public:
+	[[nodiscard]] bool started() const { return m_started; }
+	[[nodiscard]] const NeuralNetwork& policy() const { return m_policy; }
+
+	// the policy starts as `mean` with every output's deviation at ppo_initial_std. the value network keeps its random
+	// hidden layers, its output starts at zero
+	void start(const NeuralNetwork& mean, const unsigned games)
+	{
+		m_policy = mean;
+		m_logStd.fill(std::log(ppo_initial_std));
+		for (unsigned node = 0; node < ValueNetwork::dims[ValueNetwork::weightLayers]; ++node)
+		{
+			m_value.bias(ValueNetwork::weightLayers - 1, node) = 0.f;
+			for (unsigned input = 0; input < ValueNetwork::dims[ValueNetwork::weightLayers - 1]; ++input)
+				m_value.weight(ValueNetwork::weightLayers - 1, node, input) = 0.f;
+		}
+
+		m_capacity = GameSettings::gameFrameLength;
+		const size_t entries = static_cast<size_t>(games) * m_capacity;
+		m_steps.assign(games, 0);
+		m_observations.assign(entries * observations, 0.f);
+		m_actions.assign(entries * actions, 0.f);
+		for (std::vector<float>* values : { &m_logProbability, &m_values, &m_rewards, &m_advantages, &m_returns })
+			values->assign(entries, 0.f);
+		m_finalObservations.assign(static_cast<size_t>(games) * observations, 0.f);
+		m_finalValues.assign(games, 0.f);
+		m_started = true;
+	}
+
+	void beginRollout() { std::fill(m_steps.begin(), m_steps.end(), 0u); }
+
+	// the learner of `game` decides: its observation is recorded and `action` gets a sample of the policy's gaussian,
+	// clamped to the steering range. every game draws from its own `rng`, so different games can decide at the same time
+	void decide(const unsigned game, const float* observation, float* action, CounterRng& rng)
+	{
+		const size_t entry = static_cast<size_t>(game) * m_capacity + m_steps[game]++;
+		float* recorded = &m_actions[entry * actions];
+		std::copy_n(observation, observations, &m_observations[entry * observations]);
+
+		NeuralNetwork::Activations values{};
+		std::copy_n(observation, observations, values.inputs.data());
+		m_policy.compute_output(values);
+		const float* mean = values.outputs.data();
+
+		for (unsigned i = 0; i < actions; i += 2)
+		{
+			// box muller, two gaussians from two uniforms
+			const float radius = std::sqrt(-2.f * std::log(1.f - rng.uniform01()));
+			const float angle = 6.2831853f * rng.uniform01();
+			recorded[i] = mean[i] + std::exp(m_logStd[i]) * radius * std::cos(angle);
+			if (i + 1 < actions)
+				recorded[i + 1] = mean[i + 1] + std::exp(m_logStd[i + 1]) * radius * std::sin(angle);
+		}
+
+		for (unsigned i = 0; i < actions; ++i)
+			action[i] = std::clamp(recorded[i], -1.f, 1.f);
+
+		m_logProbability[entry] = logProbability(mean, recorded);
+		m_rewards[entry] = 0.f;
+	}
+
+	// what happened to `game` since its last decision, `reward` is added to that decision's
+	void reward(const unsigned game, const float reward)
+	{
+		if (m_steps[game] != 0)
+			m_rewards[static_cast<size_t>(game) * m_capacity + m_steps[game] - 1] += reward * ppo_reward_scale;
+	}
+
+	// `game` ran out of time with its learner seeing `observation`
+	void finish(const unsigned game, const float* observation)
+	{
+		std::copy_n(observation, observations, &m_finalObservations[static_cast<size_t>(game) * observations]);
+	}
+
+	// learns from the rollout. the shuffles draw from the calling thread's stream
+	void update(WorkStealingPool& pool)
+	{
+		constexpr unsigned chunk = 4 * blockRows; // decisions a worker takes at a time
+
+		m_samples.clear();
+		for (unsigned game = 0; game < m_steps.size(); ++game)
+		{
+			for (unsigned step = 0; step < m_steps[game]; ++step)
+				m_samples.push_back(game * m_capacity + step);
+		}
+		if (m_samples.empty())
+			return;
+
+		m_workers.resize(pool.size());
+		const auto samples = static_cast<unsigned>(m_samples.size());
+		pool.parallelFor(samples, chunk, [&](const unsigned first, const unsigned last, const unsigned worker)
+		{
+			estimate(first, last, m_workers[worker]);
+		});
+
+		// generalised advantage estimation. a game does not end in a state worth nothing, it is cut off by the frame
+		// limit (which the observation does not show), so the last decision bootstraps from the value of where the
+		// game was left rather than from zero
+		estimateFinal(m_workers[0]);
+		for (unsigned game = 0; game < m_steps.size(); ++game)
+		{
+			const size_t first = static_cast<size_t>(game) * m_capacity;
+			float advantage = 0, nextValue = m_finalValues[game];
+			for (unsigned step = m_steps[game]; step-- > 0;)
+			{
+				const size_t entry = first + step;
+				const float delta = m_rewards[entry] + ppo_discount * nextValue - m_values[entry];
+				advantage = delta + ppo_discount * ppo_gae_lambda * advantage;
+				m_advantages[entry] = advantage;
+				m_returns[entry] = advantage + m_values[entry];
+				nextValue = m_values[entry];
+			}
+		}
+
+		// the advantages are normalised over the rollout, the step size no longer depends on the reward scale
+		double sum = 0, squares = 0;
+		for (const unsigned entry : m_samples)
+		{
+			sum += m_advantages[entry];
+			squares += static_cast<double>(m_advantages[entry]) * m_advantages[entry];
+		}
+		const double mean = sum / samples;
+		const float deviation = static_cast<float>(std::sqrt(std::max(squares / samples - mean * mean, 0.0))) + 1e-8f;
+		for (const unsigned entry : m_samples)
+			m_advantages[entry] = static_cast<float>(m_advantages[entry] - mean) / deviation;
+
+		for (unsigned epoch = 0; epoch < ppo_epochs; ++epoch)
+		{
+			for (unsigned i = samples - 1; i > 0; --i)
+				std::swap(m_samples[i], m_samples[RandomDist::randRange(0u, i)]);
+
+			for (unsigned begin = 0; begin < samples; begin += ppo_minibatch)
+			{
+				const unsigned batch = std::min(ppo_minibatch, samples - begin);
+				for (Worker& worker : m_workers)
+					worker.clear();
+
+				pool.parallelFor(batch, chunk, [&](const unsigned first, const unsigned last, const unsigned worker)
+				{
+					accumulate(begin + first, begin + last, m_workers[worker]);
+				});
+
+				Worker& total = m_workers[0];
+				for (unsigned worker = 1; worker < m_workers.size(); ++worker)
+				{
+					for (unsigned i = 0; i < policyParameters; ++i) total.policy[i] += m_workers[worker].policy[i];
+					for (unsigned i = 0; i < valueParameters; ++i) total.value[i] += m_workers[worker].value[i];
+					for (unsigned i = 0; i < actions; ++i) total.logStd[i] += m_workers[worker].logStd[i];
+				}
+
+				const float scale = 1.f / static_cast<float>(batch);
+				for (float& value : total.policy) value *= scale;
+				for (float& value : total.value) value *= scale;
+				for (float& value : total.logStd) value *= scale;
+				clipNorm(total.policy);
+				clipNorm(total.value);
+
+				m_policyAdam.step(m_policy.parameters.data(), total.policy.data(), ppo_learning_rate);
+				m_valueAdam.step(m_value.parameters.data(), total.value.data(), ppo_value_learning_rate);
+				m_logStdAdam.step(m_logStd.data(), total.logStd.data(), ppo_learning_rate);
+				for (float& logStd : m_logStd)
+					logStd = std::max(logStd, std::log(ppo_min_std));
+			}
+		}
+	}
+};
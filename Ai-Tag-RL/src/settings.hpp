@@ -6,24 +6,43 @@
 struct Settings
 {
 	static constexpr unsigned parrelelGames      = 100;
+	static constexpr unsigned threadCount        = 0;  // worker threads stepping the games, 0 = every hardware thread
+	static constexpr unsigned gamesPerChunk      = 8;  // smallest unit of work a thread can steal, one 8-wide physics step
+	static constexpr bool     fusedEpisodes      = false; // play each game's whole episode in one go instead of frame by frame
+	static constexpr bool     batchedInference   = true;  // evaluate a slot's networks for a whole chunk of games at once
+	static constexpr bool     simultaneousTicks  = false; // all agents observe the same frame, then move and collide together
+	static constexpr unsigned decisionInterval   = 1;     // the networks steer every this many frames, in between the agents hold their last outputs
+	static constexpr bool     staggerDecisions   = false; // offset the deciding frames chunk by chunk so every frame runs about as many networks
+	static constexpr bool     racing             = false; // pick the best network by successive halving instead of one full episode each
+	static constexpr unsigned raceRounds         = 4;     // each round drops the worse half and doubles the survivors' frames
+	static constexpr bool     steadyState        = false; // no generation barrier, every finished game is replaced by a child of the elite at once
+	static constexpr unsigned eliteSize          = 16;    // networks the steady state evolution breeds from
+	static constexpr bool     evolutionStrategies = false; // move one centre network along rank weighted antithetic noise instead of mutating the best
+	static constexpr bool     proximalPolicy     = false; // train one gaussian policy by ppo on every game's decisions instead of evolving
 
 	static constexpr unsigned frameRate          = 800;
 	static constexpr unsigned bufferCirclePoints = 20;
 	static constexpr unsigned alignmentFreq      = 30'000;
 	static constexpr unsigned autoSaveFreq       = 250;
+	static constexpr unsigned statsFreq          = 10;  // how often (generations) the stats line is printed
+	static constexpr unsigned snapshotRate       = 100; // how many times a second game 0 is handed to the renderer
 
 
 	inline static const sf::Vector2f   windowSize    = { 800, 800 };
-	inline static const sf::Color      windowColor   = { 20, 20, 20 };
 	inline static const CircularBorder bounds{{windowSize.x/2, windowSize.y/2}, 350.f};
 
 	inline static const std::string simulationName = "TAG AI Sim";
 	inline static const std::string saveFileName = "data/data.json";
 
+	// the headless build never links sfml-graphics, so nothing in it may construct an sf::Color
+#ifndef HEADLESS
+	inline static const sf::Color windowColor = { 20, 20, 20 };
+
 	inline static std::vector<sf::Color> colors = {
 		{0, 90, 255, 255},// blue
 		{0, 255, 100, 255},  // green
 	};
+#endif
 };
 
 
@@ -32,13 +51,25 @@ struct GameSettings
 	static constexpr unsigned agentsPergame     = 2;
 	static constexpr unsigned gameFrameLength   = 2000;
 	static constexpr unsigned gameStartImmunity = 50;
+	static constexpr unsigned spatialGridAgents = 64; // games with at least this many agents find collisions through a grid, see --bench-physics
+
+	// early termination: a game whose play has settled is ended and the learner's remaining score extrapolated
+	static constexpr bool     earlyTermination      = false;
+	static constexpr unsigned steadyWindow          = 100;  // frames per measurement
+	static constexpr unsigned steadyWindows         = 3;    // calm windows in a row (no tags, same mean speed) before a game may end
+	static constexpr float    maxSpeedChange        = 0.2f;  // how much the agents' mean speed may change between calm windows, relative
+	static constexpr float    minSpeedChange        = 0.05f; // plus this many pixels per frame, so agents at rest are not held to nothing
+	static constexpr float    maxGapChange          = 10.f; // how much the learner's distance to the nearest other agent may change over a calm window
+	static constexpr float    maxExtrapolationError = 1.0f; // score rate spread over the calm windows times the frames left has to stay below this
 };
 
 
 struct AgentSettings
 {
+#ifndef HEADLESS
 	inline static const sf::Color notItColor = { 50, 50, 50, 255 };
 	inline static const sf::Color itColor    = { 255, 0, 0, 255 };
+#endif
 
 	static constexpr float friction = 1.00f;
 	static constexpr float maxSpeed = 16.50f;
@@ -55,10 +86,11 @@ struct AgentSettings
 struct NetSettings
 {
 	static constexpr unsigned NetworkLayers =4;
-	static constexpr unsigned NN_dims[NetworkLayers] = {GameSettings::agentsPergame * 5, 18, 18, 2 };
-
-	static constexpr unsigned largestnonInpLayer = NN_dims[1];
-	static constexpr unsigned largestLayer = NN_dims[1];
+	// the network sees its own agent and the nearest observedAgents others, nearest first, so the input layer stops
+	// growing with the game. games with fewer agents leave the missing ones zeroed, a policy runs in any game size
+	static constexpr unsigned maxObservedAgents = 8;
+	static constexpr unsigned observedAgents = GameSettings::agentsPergame - 1 < maxObservedAgents ? GameSettings::agentsPergame - 1 : maxObservedAgents;
+	static constexpr unsigned NN_dims[NetworkLayers] = {(1 + observedAgents) * 5, 18, 18, 2 };
 
 	inline static constexpr float weight_mutation_rate = 0.5f;
 	inline static constexpr float weight_mutation_range= 0.5f;
@@ -66,4 +98,25 @@ struct NetSettings
 	inline static constexpr float bias_mutation_rate  = 0.5f;
 	inline static constexpr float bias_mutation_range = 0.5f;
 
+	// evolution strategies (--es), see evolution_strategies.hpp
+	inline static constexpr float    es_noise_std     = 0.05f;   // sigma, how far a game's network is from the centre
+	inline static constexpr float    es_learning_rate = 0.02f;
+	inline static constexpr float    es_weight_decay  = 0.005f;  // pulls the centre back towards zero every step
+	inline static constexpr unsigned es_noise_table   = 1 << 20; // gaussian samples every game's noise is a stretch of
+
+	// proximal policy optimisation (--ppo), see ppo.hpp
+	static constexpr unsigned ppo_value_dims[NetworkLayers] = { NN_dims[0], 32, 32, 1 }; // the value network, its output is linear
+	inline static constexpr float    ppo_learning_rate       = 3e-4f;
+	inline static constexpr float    ppo_value_learning_rate = 1e-3f;
+	inline static constexpr float    ppo_clip         = 0.2f;  // how far a step may move a decision's probability ratio from 1
+	inline static constexpr float    ppo_discount     = 0.99f; // per decision
+	inline static constexpr float    ppo_gae_lambda   = 0.95f;
+	inline static constexpr float    ppo_entropy      = 0.001f;
+	inline static constexpr float    ppo_initial_std  = 0.5f;  // of the steering outputs, which the agents clamp to [-1, 1]
+	inline static constexpr float    ppo_min_std      = 0.05f;
+	inline static constexpr float    ppo_reward_scale = 0.05f; // a decision's reward is minus the learner's score since, times this
+	inline static constexpr float    ppo_max_gradient = 0.5f;  // the minibatch gradients are clipped to this norm
+	inline static constexpr unsigned ppo_epochs       = 3;     // passes over every rollout
+	inline static constexpr unsigned ppo_minibatch    = 4096;  // decisions per step
+
 };
\ No newline at end of file
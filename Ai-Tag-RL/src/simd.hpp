@@ -0,0 +1,239 @@
+#pragma once
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define AITAG_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// gcc and clang only let a function use avx2 instructions when it asks for them, msvc always allows it.
+// this way only the kernels below need avx2, the rest of the program still runs on any x86 cpu
+// AITAG_TARGET_AVX2_NOFMA is for kernels that have to match their scalar version bit for bit, with fma available
+// gcc would fuse their a * b + c into one rounding
+#if defined(AITAG_X86) && (defined(__GNUC__) || defined(__clang__))
+#define AITAG_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define AITAG_TARGET_AVX2_NOFMA __attribute__((target("avx2")))
+#else
+#define AITAG_TARGET_AVX2
+#define AITAG_TARGET_AVX2_NOFMA
+#endif
+
+
+// the vectorised kernels behind the network forward passes. a dense layer is
+//     out[n] = tanh(2 * (biases[n] + dot(weights[n], in)))    for n < nodes
+// with weight row n starting at weights + n * rowStride. `length` (how much of `in` and of every row is read) and the
+// room in `out` must be padded to a multiple of Simd::width, with zeros in the padding, so the kernels never need a
+// scalar tail. the padding nodes of `out` are written as 0.
+// the shared form runs `rows` inputs through the same layer: input row r starts at in + r * length and its output at
+// out + r * padded(nodes). every row gives exactly the same numbers as the single row kernel, each weight row is just
+// loaded once for a group of inputs instead of once per input.
+// the instruction set is picked once at startup: avx2 + fma when the cpu has it, otherwise the scalar loop
+// (which is the original compute_output maths, tanh in double precision)
+struct Simd
+{
+	static constexpr unsigned width = 8;
+
+	static constexpr unsigned padded(const unsigned count) { return (count + width - 1) / width * width; }
+
+	using DenseLayerKernel = void (*)(const float* weights, unsigned rowStride, const float* biases,
+		const float* in, unsigned length, float* out, unsigned nodes);
+
+	using SharedDenseLayerKernel = void (*)(const float* weights, unsigned rowStride, const float* biases,
+		const float* in, unsigned length, float* out, unsigned nodes, unsigned rows);
+
+
+	static void denseTanhScalar(const float* weights, const unsigned rowStride, const float* biases,
+		const float* in, const unsigned length, float* out, const unsigned nodes)
+	{
+		for (unsigned node = 0; node < nodes; ++node)
+		{
+			const float* row = weights + node * rowStride;
+			float dotted = biases[node];
+
+			for (unsigned i = 0; i < length; ++i)
+				dotted += row[i] * in[i];
+
+			out[node] = static_cast<float>(tanh(dotted * 2.0));
+		}
+
+		for (unsigned node = nodes; node < padded(nodes); ++node)
+			out[node] = 0.f;
+	}
+
+	static void denseTanhSharedScalar(const float* weights, const unsigned rowStride, const float* biases,
+		const float* in, const unsigned length, float* out, const unsigned nodes, const unsigned rows)
+	{
+		for (unsigned row = 0; row < rows; ++row)
+			denseTanhScalar(weights, rowStride, biases, in + row * length, length, out + row * padded(nodes), nodes);
+	}
+
+
+#ifdef AITAG_X86
+	// e^x for 8 floats (the cephes polynomial), relative error around 1e-7
+	AITAG_TARGET_AVX2 static __m256 exp8(__m256 x)
+	{
+		x = _mm256_min_ps(x, _mm256_set1_ps(88.3762626647949f));
+		x = _mm256_max_ps(x, _mm256_set1_ps(-88.3762626647949f));
+
+		// e^x = 2^n * e^r with n = round(x / ln2)
+		__m256 n = _mm256_floor_ps(_mm256_fmadd_ps(x, _mm256_set1_ps(1.44269504088896341f), _mm256_set1_ps(0.5f)));
+		x = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+		x = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), x);
+
+		__m256 y = _mm256_set1_ps(1.9875691500E-4f);
+		y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.3981999507E-3f));
+		y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(8.3334519073E-3f));
+		y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(4.1665795894E-2f));
+		y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.6666665459E-1f));
+		y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(5.0000001201E-1f));
+		y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), _mm256_add_ps(x, _mm256_set1_ps(1.f)));
+
+		const __m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(n), _mm256_set1_epi32(127)), 23);
+		return _mm256_mul_ps(y, _mm256_castsi256_ps(exponent));
+	}
+
+	// tanh(x) = sign(x) * (1 - 2 / (e^2|x| + 1)), past |x| = 9 it is 1 to float precision
+	AITAG_TARGET_AVX2 static __m256 tanh8(const __m256 x)
+	{
+		const __m256 signMask = _mm256_set1_ps(-0.f);
+		const __m256 absX = _mm256_min_ps(_mm256_andnot_ps(signMask, x), _mm256_set1_ps(9.f));
+
+		const __m256 e = exp8(_mm256_add_ps(absX, absX));
+		const __m256 t = _mm256_sub_ps(_mm256_set1_ps(1.f), _mm256_div_ps(_mm256_set1_ps(2.f), _mm256_add_ps(e, _mm256_set1_ps(1.f))));
+		return _mm256_or_ps(t, _mm256_and_ps(x, signMask));
+	}
+
+	AITAG_TARGET_AVX2 static float horizontalSum(const __m256 v)
+	{
+		__m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+		sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+		return _mm_cvtss_f32(sum);
+	}
+
+	AITAG_TARGET_AVX2 static void denseTanhAvx2(const float* weights, const unsigned rowStride, const float* biases,
+		const float* in, const unsigned length, float* out, const unsigned nodes)
+	{
+		// the dot products, 8 weights per fused multiply-add
+		for (unsigned node = 0; node < nodes; ++node)
+		{
+			const float* row = weights + node * rowStride;
+			__m256 sum = _mm256_setzero_ps();
+
+			for (unsigned i = 0; i < length; i += width)
+				sum = _mm256_fmadd_ps(_mm256_loadu_ps(row + i), _mm256_loadu_ps(in + i), sum);
+
+			out[node] = horizontalSum(sum) + biases[node];
+		}
+
+		// then the activation, 8 nodes at a time (the padding nodes come out as tanh(0) = 0)
+		for (unsigned node = nodes; node < padded(nodes); ++node)
+			out[node] = 0.f;
+
+		for (unsigned node = 0; node < nodes; node += width)
+		{
+			const __m256 dotted = _mm256_loadu_ps(out + node);
+			_mm256_storeu_ps(out + node, tanh8(_mm256_add_ps(dotted, dotted)));
+		}
+	}
+
+	AITAG_TARGET_AVX2 static void denseTanhSharedAvx2(const float* weights, const unsigned rowStride, const float* biases,
+		const float* in, const unsigned length, float* out, const unsigned nodes, const unsigned rows)
+	{
+		constexpr unsigned group = 4; // inputs sharing one load of a weight row
+		const unsigned outStride = padded(nodes);
+
+		unsigned row = 0;
+		for (; row + group <= rows; row += group)
+		{
+			const float* in0 = in + row * length;
+			float* out0 = out + row * outStride;
+
+			for (unsigned node = 0; node < nodes; ++node)
+			{
+				const float* weightRow = weights + node * rowStride;
+				__m256 sum0 = _mm256_setzero_ps(), sum1 = _mm256_setzero_ps(), sum2 = _mm256_setzero_ps(), sum3 = _mm256_setzero_ps();
+
+				for (unsigned i = 0; i < length; i += width)
+				{
+					const __m256 w = _mm256_loadu_ps(weightRow + i);
+					sum0 = _mm256_fmadd_ps(w, _mm256_loadu_ps(in0 + i), sum0);
+					sum1 = _mm256_fmadd_ps(w, _mm256_loadu_ps(in0 + length + i), sum1);
+					sum2 = _mm256_fmadd_ps(w, _mm256_loadu_ps(in0 + 2 * length + i), sum2);
+					sum3 = _mm256_fmadd_ps(w, _mm256_loadu_ps(in0 + 3 * length + i), sum3);
+				}
+
+				out0[node]                 = horizontalSum(sum0) + biases[node];
+				out0[outStride + node]     = horizontalSum(sum1) + biases[node];
+				out0[2 * outStride + node] = horizontalSum(sum2) + biases[node];
+				out0[3 * outStride + node] = horizontalSum(sum3) + biases[node];
+			}
+
+			for (unsigned r = 0; r < group; ++r)
+			{
+				float* outRow = out0 + r * outStride;
+				for (unsigned node = nodes; node < outStride; ++node)
+					outRow[node] = 0.f;
+
+				for (unsigned node = 0; node < nodes; node += width)
+				{
+					const __m256 dotted = _mm256_loadu_ps(outRow + node);
+					_mm256_storeu_ps(outRow + node, tanh8(_mm256_add_ps(dotted, dotted)));
+				}
+			}
+		}
+
+		for (; row < rows; ++row)
+			denseTanhAvx2(weights, rowStride, biases, in + row * length, length, out + row * outStride, nodes);
+	}
+#endif
+
+
+	static bool cpuHasAvx2()
+	{
+#if defined(AITAG_X86) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) return false;
+
+		__cpuid(info, 1);
+		const bool fma = (info[2] & (1 << 12)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		if (!fma || !osxsave || (_xgetbv(0) & 6) != 6) return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#elif defined(AITAG_X86)
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+		return false;
+#endif
+	}
+
+	static DenseLayerKernel selectDenseKernel()
+	{
+#ifdef AITAG_X86
+		if (cpuHasAvx2())
+			return &denseTanhAvx2;
+#endif
+		return &denseTanhScalar;
+	}
+
+	static SharedDenseLayerKernel selectSharedDenseKernel()
+	{
+#ifdef AITAG_X86
+		if (cpuHasAvx2())
+			return &denseTanhSharedAvx2;
+#endif
+		return &denseTanhSharedScalar;
+	}
+
+	inline static const DenseLayerKernel denseTanh = selectDenseKernel();
+	inline static const SharedDenseLayerKernel denseTanhShared = selectSharedDenseKernel();
+
+	static const char* isaName() { return denseTanh == &denseTanhScalar ? "scalar" : "avx2+fma"; }
+};
@@ -0,0 +1,796 @@
+#include "simulation.hpp"
+
+#include <filesystem>
+
+
+// steps one full generation with 1, 2, 4 ... hardware threads and prints the game steps per second of each
+void Simulation::benchmarkThreadCounts()
+{
+	const unsigned maxThreads = WorkStealingPool::hardwareThreads();
+	const unsigned previousThreads = m_threadPool->size();
+
+	std::vector<unsigned> threadCounts{};
+	for (unsigned threads = 1; threads < maxThreads; threads *= 2)
+		threadCounts.push_back(threads);
+	threadCounts.push_back(maxThreads);
+
+	std::cout << "[benchmark]: " << parrelelGames << " games, " << GameSettings::gameFrameLength << " frames each\n";
+
+	for (const unsigned threads : threadCounts)
+	{
+		m_threadPool = std::make_unique<WorkStealingPool>(threads);
+		resetGames();
+
+		const auto start = std::chrono::steady_clock::now();
+		bool stop = false;
+		while (!stop)
+			tickGames(stop);
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << "[benchmark]: " << threads << " threads, "
+			<< static_cast<unsigned long long>(parrelelGames * GameSettings::gameFrameLength / seconds) << " game steps/s\n";
+	}
+
+	m_threadPool = std::make_unique<WorkStealingPool>(previousThreads);
+	m_genSteps = 0;
+}
+
+
+// plays the same generations frame by frame across all games (lockstep) and game by game (fused), each with one
+// network call per agent and with batched inference, with sequential and simultaneous ticks, and prints the step rate
+// of every combination
+void Simulation::benchmarkSteppingModes()
+{
+	constexpr unsigned generations = 3;
+	const unsigned long long steps = static_cast<unsigned long long>(parrelelGames) * GameSettings::gameFrameLength * generations;
+	const bool previousFused = m_fusedEpisodes;
+	const bool previousBatched = m_batchedInference;
+	const bool previousSimultaneous = m_simultaneousTicks;
+
+	std::cout << "[benchmark]: " << parrelelGames << " games, " << GameSettings::gameFrameLength << " frames each, "
+		<< generations << " generations, " << m_threadPool->size() << " threads\n";
+
+	double baseline = 0;
+	for (const bool simultaneous : { false, true })
+	{
+		for (const bool fused : { false, true })
+		{
+			for (const bool batched : { false, true })
+			{
+				m_fusedEpisodes = fused;
+				m_batchedInference = batched;
+				m_simultaneousTicks = simultaneous;
+
+				const auto start = std::chrono::steady_clock::now();
+				for (unsigned generation = 0; generation < generations; ++generation)
+				{
+					resetGames();
+					if (fused)
+						runGenerationFused();
+					else
+						runGenerationLockstep();
+				}
+				const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+				const double stepsPerSecond = steps / seconds;
+				if (baseline == 0)
+					baseline = stepsPerSecond;
+
+				std::cout << "[benchmark]: " << (simultaneous ? "simultaneous " : "sequential   ")
+					<< (fused ? "fused   " : "lockstep") << (batched ? " batched  " : " per agent")
+					<< " " << static_cast<unsigned long long>(stepsPerSecond) << " game steps/s (" << stepsPerSecond / baseline << "x)\n";
+			}
+		}
+	}
+
+	m_fusedEpisodes = previousFused;
+	m_batchedInference = previousBatched;
+	m_simultaneousTicks = previousSimultaneous;
+	m_genSteps = 0;
+}
+
+
+// trains a fresh population from the same run seed once for every decision interval and prints its learning curve,
+// the best learner score every few generations, and its game steps per second. each run's scores are played at its
+// own interval, so the curves show how well each setting learns, not one common yardstick
+void Simulation::benchmarkDecisionIntervals(const unsigned threads, const unsigned generations, const bool staggered)
+{
+	constexpr unsigned curvePoints = 5;
+	const unsigned every = std::max(generations / curvePoints, 1u);
+	const uint64_t seed = RandomDist::runSeed;
+
+	std::vector<std::string> results{};
+	for (const unsigned interval : { 1u, 2u, 4u, 8u })
+	{
+		// the simulation's members already draw before its constructor seeds, so this thread's stream is put back to
+		// where a fresh process starts it
+		RandomDist::setRunSeed(seed);
+		RandomDist::seed(RandomDist::Init, 0, 0);
+		Simulation simulation{ threads };
+		simulation.setDecisionInterval(interval, staggered);
+
+		std::ostringstream curve{};
+		const auto start = std::chrono::steady_clock::now();
+		for (unsigned generation = 1; generation <= generations; ++generation)
+		{
+			simulation.resetGames();
+			simulation.runGeneration();
+			simulation.prepareNextAgents();
+			++simulation.m_generationCount;
+
+			if (generation % every == 0)
+				curve << " " << simulation.best_net_info.score;
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::ostringstream line{};
+		line << "[benchmark]: interval " << interval << ", " << static_cast<unsigned long long>(
+			static_cast<double>(parrelelGames) * GameSettings::gameFrameLength * generations / seconds) << " game steps/s, best score" << curve.str();
+		results.push_back(line.str());
+	}
+
+	std::cout << "[benchmark]: " << generations << " generations per interval from run seed " << seed
+		<< (staggered ? ", staggered" : "") << ", best score every " << every << " generations (lower is better)\n";
+	for (const std::string& line : results)
+		std::cout << line << "\n";
+}
+
+
+// plays every generation twice from the same start, at full length and with early termination, and trains on the
+// early terminated one. prints how many frames were skipped, how far the extrapolated learner scores ended up from
+// the full length ones, how many missed the error budget (the game flared up again after it looked settled) and in
+// how many generations a different best network would have been picked
+void Simulation::benchmarkEarlyTermination(const unsigned generations)
+{
+	const bool previous = m_earlyTermination;
+	std::vector<float> fullScores(parrelelGames);
+
+	double seconds[2] = {};
+	unsigned long long skipped = 0;
+	unsigned endedEarly = 0, missedBudget = 0, bestChanged = 0;
+	double errorSum = 0;
+	float maxError = 0;
+
+	for (unsigned generation = 0; generation < generations; ++generation)
+	{
+		unsigned fullBest = 0;
+		for (const bool early : { false, true })
+		{
+			setEarlyTermination(early);
+			resetGames();
+
+			const auto start = std::chrono::steady_clock::now();
+			runGeneration();
+			seconds[early] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			if (!early)
+			{
+				for (unsigned i = 0; i < parrelelGames; ++i)
+					fullScores[i] = m_agents.score[m_agents.index(0, i)];
+				fullBest = bestLearner();
+				continue;
+			}
+
+			bestChanged += bestLearner() != fullBest;
+			for (unsigned i = 0; i < parrelelGames; ++i)
+			{
+				const Game& game = m_allGames[i];
+				if (game.framesSkipped == 0)
+					continue;
+
+				const float error = std::abs(m_agents.score[m_agents.index(0, i)] - fullScores[i]);
+				++endedEarly;
+				skipped += game.framesSkipped;
+				errorSum += error;
+				maxError = std::max(maxError, error);
+				missedBudget += error > GameSettings::maxExtrapolationError;
+			}
+		}
+
+		prepareNextAgents();
+		++m_generationCount;
+	}
+
+	const double games = static_cast<double>(parrelelGames) * generations;
+	std::cout << "[benchmark]: " << generations << " generations of " << parrelelGames << " games, full length vs early termination\n"
+		<< "[benchmark]: " << 100.0 * skipped / (games * GameSettings::gameFrameLength) << "% of frames skipped, "
+		<< 100.0 * endedEarly / games << "% of games ended early, " << seconds[0] / seconds[1] << "x faster\n"
+		<< "[benchmark]: extrapolated score error mean " << (endedEarly ? errorSum / endedEarly : 0) << ", max " << maxError
+		<< ", " << missedBudget << " games past the " << GameSettings::maxExtrapolationError << " budget\n"
+		<< "[benchmark]: best network changed in " << bestChanged << " of " << generations << " generations\n";
+
+	setEarlyTermination(previous);
+	m_genSteps = 0;
+}
+
+
+// trains a fresh population from the same run seed once picking every generation's best network from one full length
+// game per candidate and once by racing them (runRace), then plays each generation's pick against the opponent it was
+// picked against from a fresh start in every game. prints the mean score the pick was chosen with, the mean it gets
+// on those held out starts (the difference is how much of the pick was luck of the spawn), the frames each way costs
+// and its time
+void Simulation::benchmarkRacing(const unsigned threads, const unsigned generations)
+{
+	const uint64_t seed = RandomDist::runSeed;
+
+	std::vector<std::string> results{};
+	for (const bool racing : { false, true })
+	{
+		// the simulation's members already draw before its constructor seeds, so this thread's stream is put back to
+		// where a fresh process starts it
+		RandomDist::setRunSeed(seed);
+		RandomDist::seed(RandomDist::Init, 0, 0);
+		Simulation simulation{ threads };
+		simulation.setRacing(racing);
+
+		double picked = 0, heldOut = 0, seconds = 0;
+		unsigned long long frames = 0;
+		for (unsigned generation = 1; generation <= generations; ++generation)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			if (racing)
+				simulation.runRace();
+			else
+			{
+				simulation.resetGames();
+				simulation.runGeneration();
+			}
+			seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			frames += simulation.m_genSteps;
+			simulation.m_genSteps = 0;
+
+			// the pool slot the opponent lives in can be overwritten while the next generation is prepared
+			const NeuralNetwork opponent = *simulation.m_allGames[0].opponent;
+			simulation.prepareNextAgents();
+			picked += simulation.best_net_info.score;
+			heldOut += simulation.heldOutScore(simulation.m_bestNetwork, opponent);
+			++simulation.m_generationCount;
+		}
+
+		std::ostringstream line{};
+		line << "[benchmark]: " << (racing ? "racing     " : "full length") << " picked score " << picked / generations
+			<< ", held out score " << heldOut / generations << ", " << frames / generations << " frames per generation, "
+			<< seconds << "s";
+		results.push_back(line.str());
+	}
+
+	std::cout << "[benchmark]: " << generations << " generations from run seed " << seed << ", " << parrelelGames
+		<< " candidates, " << raceRounds << " race rounds, scores per full length game (lower is better)\n";
+	for (const std::string& line : results)
+		std::cout << line << "\n";
+}
+
+
+// trains a fresh population from the same run seed for `generations` generations, once generation by generation and
+// once as the steady state evolution (runSteadyState), and prints how many games a second each finished and the best
+// score it ended on. with early termination the games end at different frames, which is where waiting for the
+// slowest game of every generation costs the most
+void Simulation::benchmarkSteadyState(const unsigned threads, const unsigned generations, const bool earlyTermination)
+{
+	const uint64_t seed = RandomDist::runSeed;
+
+	std::vector<std::string> results{};
+	for (const bool steady : { false, true })
+	{
+		// the simulation's members already draw before its constructor seeds, so this thread's stream is put back to
+		// where a fresh process starts it
+		RandomDist::setRunSeed(seed);
+		RandomDist::seed(RandomDist::Init, 0, 0);
+		Simulation simulation{ threads };
+		simulation.setSteadyState(steady);
+		simulation.setEarlyTermination(earlyTermination);
+		simulation.setRunLimits(generations, 0);
+
+		const auto start = std::chrono::steady_clock::now();
+		simulation.trainingLoop();
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::ostringstream line{};
+		line << "[benchmark]: " << (steady ? "steady state" : "generations ") << " "
+			<< static_cast<unsigned long long>(static_cast<double>(parrelelGames) * (simulation.m_generationCount - 1) / seconds)
+			<< " games/s, best score " << simulation.best_net_info.score << ", " << seconds << "s";
+		results.push_back(line.str());
+	}
+
+	std::cout << "[benchmark]: " << generations << " generations of " << parrelelGames << " games from run seed " << seed
+		<< ", " << threads << " threads" << (earlyTermination ? ", early termination" : "") << "\n";
+	for (const std::string& line : results)
+		std::cout << line << "\n";
+}
+
+
+// trains a fresh population from the same run seed by mutating the best network and by evolution strategies, and
+// every few generations plays each one's current network (the best one, or the centre) against the opponent it
+// trained against from a fresh start in every game. prints those held out scores, the curve of how well each
+// setting learns, and the time each took
+void Simulation::benchmarkEvolutionStrategies(const unsigned threads, const unsigned generations)
+{
+	constexpr unsigned curvePoints = 5;
+	const unsigned every = std::max(generations / curvePoints, 1u);
+	const uint64_t seed = RandomDist::runSeed;
+
+	std::vector<std::string> results{};
+	for (const bool strategies : { false, true })
+	{
+		// the simulation's members already draw before its constructor seeds, so this thread's stream is put back to
+		// where a fresh process starts it
+		RandomDist::setRunSeed(seed);
+		RandomDist::seed(RandomDist::Init, 0, 0);
+		Simulation simulation{ threads };
+		simulation.setEvolutionStrategies(strategies);
+
+		std::ostringstream curve{};
+		double seconds = 0;
+		for (unsigned generation = 1; generation <= generations; ++generation)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			simulation.resetGames();
+			simulation.runGeneration();
+
+			const NeuralNetwork opponent = *simulation.m_allGames[0].opponent;
+			simulation.prepareNextAgents();
+			seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			if (generation % every == 0)
+				curve << " " << simulation.heldOutScore(simulation.m_bestNetwork, opponent);
+			++simulation.m_generationCount;
+		}
+
+		std::ostringstream line{};
+		line << "[benchmark]: " << (strategies ? "evolution strategies" : "mutate the best     ") << " " << seconds << "s, held out score" << curve.str();
+		results.push_back(line.str());
+	}
+
+	std::cout << "[benchmark]: " << generations << " generations from run seed " << seed << ", held out score every "
+		<< every << " generations (lower is better)\n";
+	for (const std::string& line : results)
+		std::cout << line << "\n";
+}
+
+
+// trains a fresh population from the same run seed for `seconds` of training time by evolution (mutating the best
+// network) and by ppo. after a generation the current network (the best one, or the policy's mean) plays the first
+// opponent from a fresh start in every game, that time is not counted. prints the held out score every
+// tenth of the time and how long each took to first get to `targetScore` or below
+void Simulation::benchmarkProximalPolicy(const unsigned threads, const double seconds, const float targetScore)
+{
+	constexpr unsigned curvePoints = 10;
+	const uint64_t seed = RandomDist::runSeed;
+
+	std::vector<std::string> results{};
+	for (const bool ppo : { false, true })
+	{
+		// the simulation's members already draw before its constructor seeds, so this thread's stream is put back to
+		// where a fresh process starts it
+		RandomDist::setRunSeed(seed);
+		RandomDist::seed(RandomDist::Init, 0, 0);
+		Simulation simulation{ threads };
+		simulation.setProximalPolicy(ppo);
+
+		// the league changes every snapshot frequency generations and the two run different numbers of generations, so
+		// both are scored against the opponent they started with
+		const NeuralNetwork opponent = *simulation.m_allGames[0].opponent;
+
+		std::ostringstream curve{};
+		double trained = 0, reached = -1;
+		unsigned point = 1;
+		while (trained < seconds)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			if (ppo)
+				simulation.runRollout();
+			else
+			{
+				simulation.resetGames();
+				simulation.runGeneration();
+			}
+
+			simulation.prepareNextAgents();
+			trained += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			++simulation.m_generationCount;
+
+			// every generation is scored until the target is reached, then only the curve's points are
+			if (reached >= 0 && trained < seconds * point / curvePoints)
+				continue;
+
+			const float score = simulation.heldOutScore(simulation.m_bestNetwork, opponent);
+			if (reached < 0 && score <= targetScore)
+				reached = trained;
+			for (; point <= curvePoints && trained >= seconds * point / curvePoints; ++point)
+				curve << " " << score;
+		}
+
+		std::ostringstream line{};
+		line << "[benchmark]: " << (ppo ? "ppo      " : "evolution") << " " << simulation.m_generationCount - 1 << " generations, ";
+		if (reached >= 0)
+			line << "reached " << targetScore << " after " << reached << "s";
+		else
+			line << "never reached " << targetScore;
+		line << ", held out score" << curve.str();
+		results.push_back(line.str());
+	}
+
+	std::cout << "[benchmark]: " << seconds << "s of training from run seed " << seed << ", " << threads
+		<< " threads, held out score every " << seconds / curvePoints << "s (lower is better)\n";
+	for (const std::string& line : results)
+		std::cout << line << "\n";
+}
+
+
+// trains a fresh league from the same run seed for `generations` generations twice, a snapshot every 10 generations:
+// once drawing the opponents alike and once by prioritised fictitious self play. prints the share of games the learner
+// was expected to win easily, then lets each run's final best network play every snapshot of both leagues (the other
+// run's snapshots it never trained against) and prints its mean and worst win rate over them
+void Simulation::benchmarkLeague(const unsigned threads, const unsigned generations)
+{
+	constexpr unsigned snapshotFrequency = 10;
+	const uint64_t seed = RandomDist::runSeed;
+
+	struct Run
+	{
+		const char* name;
+		const char* label;
+		float power;
+		double easyShare = 0, seconds = 0;
+		float learnerRating = 0;
+		NeuralNetwork best{};
+		std::vector<NeuralNetwork> snapshots{};
+		std::vector<float> scores{};
+	};
+	std::vector<Run> runs{ { "uniform", "uniform", 0.f }, { "pfsp", "pfsp   ", League::pfsp_power } };
+
+	for (Run& run : runs)
+	{
+		// the simulation's members already draw before its constructor seeds, so this thread's stream is put back to
+		// where a fresh process starts it
+		RandomDist::setRunSeed(seed);
+		RandomDist::seed(RandomDist::Init, 0, 0);
+		Simulation simulation{ threads };
+		simulation.m_league.setSnapshotFrequency(snapshotFrequency);
+		simulation.m_league.setPfspPower(run.power);
+		simulation.setRunLimits(generations, 0);
+
+		const auto start = std::chrono::steady_clock::now();
+		simulation.trainingLoop();
+		run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		run.easyShare = simulation.m_league.easyShare();
+		run.learnerRating = simulation.m_league.learnerRating();
+		run.best = simulation.m_bestNetwork;
+		for (unsigned i = 0; i < simulation.m_league.size(); ++i)
+		{
+			run.snapshots.push_back(simulation.m_league.network(i));
+			run.scores.push_back(simulation.m_league.snapshots()[i].score);
+		}
+	}
+
+	// one simulation plays every cross evaluation, the same starts for every pairing
+	RandomDist::setRunSeed(seed);
+	RandomDist::seed(RandomDist::Init, 0, 0);
+	Simulation judge{ threads };
+
+	std::cout << "[benchmark]: " << generations << " generations from run seed " << seed << ", a snapshot every "
+		<< snapshotFrequency << " generations, win rates of each run's best network over every snapshot\n";
+	for (const Run& run : runs)
+	{
+		std::ostringstream line{};
+		line << "[benchmark]: " << run.label << " " << run.seconds << "s, " << run.easyShare * 100 << "% easy games, learner elo " << run.learnerRating;
+		for (const Run& league : runs)
+		{
+			double mean = 0;
+			float worst = 1;
+			for (unsigned i = 0; i < league.snapshots.size(); ++i)
+			{
+				float winRate = 0;
+				judge.heldOutScore(run.best, league.snapshots[i], &winRate, league.scores[i]);
+				mean += winRate;
+				worst = std::min(worst, winRate);
+			}
+			line << ", vs " << league.name << " league " << mean / static_cast<double>(league.snapshots.size()) * 100 << "% (worst " << worst * 100 << "%)";
+		}
+		std::cout << line.str() << "\n";
+	}
+}
+
+
+// the mean score `network` gets against `opponent` in every game, each game from its own start. the games' own
+// networks and opponent are put back afterwards. `winRate` gets the share of the games it won, as the league counts them
+// against an opponent that scored `opponentScore` as the learner
+float Simulation::heldOutScore(const NeuralNetwork& network, const NeuralNetwork& opponent, float* winRate, const float opponentScore)
+{
+	const NeuralNetwork* previousOpponent = m_allGames[0].opponent;
+	std::vector<NeuralNetwork> learners{};
+	learners.reserve(parrelelGames);
+	for (unsigned i = 0; i < parrelelGames; ++i)
+	{
+		learners.push_back(m_allGames[i].learner);
+		m_allGames[i].learner = network;
+		syncInferenceWeights(i);
+	}
+	setOpponent(&opponent);
+
+	m_threadPool->parallelFor(parrelelGames, gamesPerChunk, [&](const unsigned begin, const unsigned end, unsigned)
+	{
+		for (unsigned i = begin; i < end; ++i)
+		{
+			RandomDist::seed(RandomDist::Evaluation, m_generationCount, i);
+			m_allGames[i].initiliseGame(rearrangePositions(bounds, GameSettings::agentsPergame));
+		}
+	});
+	m_agents.markStartPositions();
+
+	runGeneration();
+
+	double score = 0, wins = 0;
+	for (unsigned i = 0; i < parrelelGames; ++i)
+	{
+		score += m_agents.score[m_agents.index(0, i)];
+		wins += leagueResult(i, opponentScore);
+		m_allGames[i].learner = learners[i];
+		syncInferenceWeights(i);
+	}
+	setOpponent(previousOpponent);
+	m_genSteps = 0;
+
+	if (winRate != nullptr)
+		*winRate = static_cast<float>(wins / parrelelGames);
+	return static_cast<float>(score / parrelelGames);
+}
+
+
+// runs the same random networks and inputs through the scalar forward pass and the one picked for this cpu, checks
+// that every output (the agent's steering) agrees within the tolerance and prints how many forward passes a second
+// each manages. returns false when the outputs differ by more than the tolerance
+bool Simulation::benchmarkForwardPass()
+{
+	constexpr unsigned networks = 256;
+	constexpr unsigned passes = 2'000;
+	constexpr float tolerance = 1e-4f;
+	constexpr unsigned outputCount = NetSettings::NN_dims[NetSettings::NetworkLayers - 1];
+
+	RandomDist::seed(RandomDist::Init, 0, 0);
+	std::vector<NeuralNetwork> nets(networks);
+	std::vector<NeuralNetwork::Activations> values(networks);
+	for (NeuralNetwork::Activations& value : values)
+	{
+		for (unsigned i = 0; i < NetSettings::NN_dims[0]; ++i)
+			value.inputs[i] = RandomDist::randRange(-1.f, 1.f);
+	}
+
+	float maxDifference = 0;
+	for (unsigned n = 0; n < networks; ++n)
+	{
+		nets[n].compute_output(values[n], &Simd::denseTanhScalar);
+		const auto expected = values[n].outputs;
+
+		nets[n].compute_output(values[n]);
+		for (unsigned i = 0; i < outputCount; ++i)
+			maxDifference = std::max(maxDifference, std::abs(values[n].outputs[i] - expected[i]));
+	}
+
+	std::cout << "[benchmark]: " << networks << " networks, " << passes << " forward passes each, simd kernel: " << Simd::isaName() << "\n";
+
+	double baseline = 0;
+	for (const Simd::DenseLayerKernel kernel : { &Simd::denseTanhScalar, Simd::denseTanh })
+	{
+		float checksum = 0; // stops the compiler from dropping the passes
+		const auto start = std::chrono::steady_clock::now();
+		for (unsigned pass = 0; pass < passes; ++pass)
+		{
+			for (unsigned n = 0; n < networks; ++n)
+			{
+				nets[n].compute_output(values[n], kernel);
+				checksum += values[n].outputs[0];
+			}
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		const double passesPerSecond = static_cast<double>(networks) * passes / seconds;
+		if (baseline == 0)
+			baseline = passesPerSecond;
+
+		std::cout << "[benchmark]: " << (kernel == &Simd::denseTanhScalar ? "scalar" : Simd::isaName()) << " "
+			<< static_cast<unsigned long long>(passesPerSecond) << " forward passes/s (" << passesPerSecond / baseline
+			<< "x, checksum " << checksum << ")\n";
+	}
+
+	const bool withinTolerance = maxDifference <= tolerance;
+	std::cout << "[benchmark]: largest output difference " << maxDifference << " (tolerance " << tolerance << ") "
+		<< (withinTolerance ? "ok" : "FAILED") << "\n";
+	return withinTolerance;
+}
+
+
+// moves the agents of every game by the same random steering and times the collision and tagging pass checking
+// every pair of agents against the one going through the spatial grid, with sequential and simultaneous ticks,
+// then times the observation encoder's nearest agent search both ways. for picking GameSettings::spatialGridAgents,
+// the crossover depends on the agent count the build was made with. returns false if the two searches disagree
+bool Simulation::benchmarkPhysics()
+{
+	constexpr unsigned frames = 2'000;
+	constexpr unsigned steeringFrames = 64; // the random outputs are drawn up front and cycled through
+	constexpr unsigned slots = GameSettings::agentsPergame;
+
+	RandomDist::seed(RandomDist::Init, 0, 0);
+	std::vector<float> steering(static_cast<size_t>(steeringFrames) * slots * parrelelGames * 2);
+	for (float& output : steering)
+		output = RandomDist::randRange(-1.f, 1.f);
+
+	std::cout << "[benchmark]: " << parrelelGames << " games of " << slots << " agents, " << frames << " frames\n";
+
+	AgentStore agents{};
+	agents.resize(parrelelGames);
+
+	double baseline = 0;
+	bool sameScores = true;
+	for (const bool simultaneous : { false, true })
+	{
+		std::vector<float> pairScores{};
+		for (const bool grid : { false, true })
+		{
+			RandomDist::seed(RandomDist::Init, 1, 0);
+			agents.useSpatialGrid(grid);
+			for (unsigned game = 0; game < parrelelGames; ++game)
+			{
+				agents.reset(game);
+				agents.tagged[agents.index(0, game)] = 1;
+			}
+
+			const auto start = std::chrono::steady_clock::now();
+			for (unsigned frame = 0; frame < frames; ++frame)
+			{
+				for (unsigned slot = 0; slot < slots; ++slot)
+				{
+					const float* outputs = &steering[((frame % steeringFrames) * slots + slot) * parrelelGames * 2];
+					if (simultaneous)
+						agents.integrate(slot, 0, parrelelGames, outputs, 2);
+					else
+						agents.act(slot, 0, parrelelGames, outputs, 2);
+				}
+
+				if (simultaneous)
+					agents.resolve(0, parrelelGames);
+			}
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			float checksum = 0;
+			for (const float score : agents.score)
+				checksum += score;
+
+			// the grid only changes which pairs are looked at, every agent has to end up with the same score
+			if (!grid)
+				pairScores = agents.score;
+			const bool same = !grid || agents.score == pairScores;
+			sameScores = sameScores && same;
+
+			const double agentSteps = static_cast<double>(parrelelGames) * slots * frames / seconds;
+			if (baseline == 0)
+				baseline = agentSteps;
+
+			std::cout << "[benchmark]: " << (simultaneous ? "simultaneous " : "sequential   ") << (grid ? "grid      " : "every pair")
+				<< " " << static_cast<unsigned long long>(agentSteps) << " agent steps/s (" << agentSteps / baseline
+				<< "x, checksum " << checksum << (same ? "" : ", scores differ from every pair") << ")\n";
+		}
+	}
+
+	// the encoder reads the agents where the last run left them
+	constexpr unsigned encodings = 20;
+	constexpr unsigned inputCount = NetSettings::NN_dims[0];
+	std::vector<float> expected(static_cast<size_t>(parrelelGames) * slots * inputCount);
+	std::vector<float> inputs(expected.size());
+
+	std::cout << "[benchmark]: observation encoder, " << NetSettings::observedAgents << " nearest agents\n";
+
+	baseline = 0;
+	for (const bool grid : { false, true })
+	{
+		agents.useSpatialGrid(grid);
+
+		const auto start = std::chrono::steady_clock::now();
+		for (unsigned pass = 0; pass < encodings; ++pass)
+		{
+			for (unsigned slot = 0; slot < slots; ++slot)
+			{
+				for (unsigned game = 0; game < parrelelGames; ++game)
+					agents.setNetworkInputs(slot, game, &inputs[agents.index(slot, game) * inputCount]);
+			}
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if (!grid)
+			expected = inputs;
+
+		const double encodingsPerSecond = static_cast<double>(parrelelGames) * slots * encodings / seconds;
+		if (baseline == 0)
+			baseline = encodingsPerSecond;
+
+		std::cout << "[benchmark]: " << (grid ? "grid      " : "every pair") << " " << static_cast<unsigned long long>(encodingsPerSecond)
+			<< " observations/s (" << encodingsPerSecond / baseline << "x)\n";
+	}
+
+	const bool identical = inputs == expected;
+	std::cout << "[benchmark]: grid and every pair score the same: " << (sameScores ? "ok" : "FAILED") << "\n";
+	std::cout << "[benchmark]: grid and every agent search pick the same agents: " << (identical ? "ok" : "FAILED") << "\n";
+	return identical && sameScores;
+}
+
+
+// the process's resident set in bytes, 0 where it cannot be read
+static size_t residentBytes()
+{
+#ifdef __linux__
+	std::ifstream statm("/proc/self/statm");
+	size_t pages = 0, resident = 0;
+	statm >> pages >> resident;
+	return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+	return 0;
+#endif
+}
+
+
+// writes `snapshots` mutated networks to a snapshot archive in the temp directory, opens it again and copies 1000
+// random ones out like the league does when it picks an opponent. prints how long appending and opening took and how
+// much the resident set grew, next to what holding them all in memory would cost. returns false if a network that
+// came back is not the one that was written
+bool Simulation::benchmarkArchive(const unsigned snapshots)
+{
+	constexpr unsigned picks = 1'000;
+	const std::string path = (std::filesystem::temp_directory_path() / "ai-tag-benchmark.snapshots").string();
+
+	RandomDist::seed(RandomDist::Init, 0, 0);
+	const NeuralNetwork parent{};
+	NeuralNetwork network{ parent };
+	std::vector<double> sums(snapshots);
+
+	double appendSeconds = 0;
+	{
+		SnapshotArchive archive{};
+		if (!archive.open(path, false))
+			return false;
+
+		for (unsigned i = 0; i < snapshots; ++i)
+		{
+			parent.mutate(&network);
+			for (const float parameter : network.parameterSpan())
+				sums[i] += parameter;
+
+			const auto start = std::chrono::steady_clock::now();
+			archive.append(network, i, static_cast<float>(i));
+			appendSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+	}
+
+	const size_t residentBefore = residentBytes();
+	const auto openStart = std::chrono::steady_clock::now();
+	SnapshotArchive archive{};
+	const bool opened = archive.open(path, true);
+	const double openSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - openStart).count();
+
+	bool ok = opened && archive.size() == snapshots;
+	const auto pickStart = std::chrono::steady_clock::now();
+	for (unsigned pick = 0; pick < picks && ok; ++pick)
+	{
+		const unsigned i = RandomDist::randRange(0u, snapshots - 1);
+		archive.load(i, &network);
+
+		double sum = 0;
+		for (const float parameter : network.parameterSpan())
+			sum += parameter;
+		ok = sum == sums[i] && archive.generation(i) == i;
+	}
+	const double pickSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - pickStart).count();
+	const size_t residentAfter = residentBytes();
+
+	archive.close();
+	std::filesystem::remove(path);
+
+	constexpr double mb = 1024.0 * 1024.0;
+	std::cout << "[benchmark]: " << snapshots << " snapshots of " << sizeof(SnapshotArchive::Record) << " bytes, "
+		<< appendSeconds / snapshots * 1e6 << "us per append, opened in " << openSeconds * 1e3 << "ms, "
+		<< picks << " random picks in " << pickSeconds * 1e3 << "ms\n";
+	std::cout << "[benchmark]: resident set grew " << (static_cast<double>(residentAfter) - static_cast<double>(residentBefore)) / mb
+		<< "MB over the picks, holding every network in memory would take " << static_cast<double>(snapshots) * sizeof(NeuralNetwork) / mb << "MB\n";
+	std::cout << "[benchmark]: " << (ok ? "every network came back as written" : "A NETWORK CAME BACK WRONG") << "\n";
+	return ok;
+}
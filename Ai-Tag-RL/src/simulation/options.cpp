@@ -0,0 +1,276 @@
+#include "simulation.hpp"
+
+#include <cstdlib>
+#include <optional>
+#include <string>
+
+// the command line both entry points take, main.cpp (the window) and headless.cpp. the window does not autosave
+// unless it is asked to (the A key), a headless run has nobody there to ask
+//
+// usage: ai-tag[-headless] [--generations N] [--minutes M] [--threads T] [--save FILE] [--seed S] [--load] [--no-autosave]
+//                          [--export-json FILE]
+//                          [--fused] [--unbatched] [--simultaneous] [--decision-interval K] [--stagger] [--early-stop]
+//                          [--race] [--steady-state] [--es] [--ppo] [--bench-threads] [--bench-modes] [--bench-network]
+//                          [--bench-physics] [--bench-decisions] [--bench-early-stop] [--bench-race] [--bench-steady]
+//                          [--bench-es] [--bench-ppo [--target S]] [--bench-league]
+//                          [--bench-archive]
+
+#ifdef HEADLESS
+static constexpr bool autoSaveByDefault = true;
+#else
+static constexpr bool autoSaveByDefault = false;
+#endif
+
+
+static void printUsage(const char* program)
+{
+	std::cout << "usage: " << program << " [options]\n"
+		<< "  --generations N   stop after generation N\n"
+		<< "  --minutes M       stop after M minutes of wall-clock time\n"
+		<< "  --threads T       worker threads (default: every hardware thread)\n"
+		<< "  --save FILE       checkpoint file to autosave to / load from (default: network_data.ckpt), the league's\n"
+		<< "                    networks go next to it (FILE.<number>.snapshots, a new one every run that does not --load,\n"
+		<< "                    a resumed run appends to the one its checkpoint names) and the saves that only hold what\n"
+		<< "                    changed since the last full checkpoint to FILE.delta\n"
+		<< "  --seed S          run seed, every game of every generation can be reproduced from it\n"
+		<< "  --load            resume from the checkpoint file (or a json export) before training, with its run seed\n"
+		<< "  --no-autosave     do not write checkpoints\n"
+		<< "  --export-json FILE  write the checkpoint, every network included, as json to FILE and exit\n"
+		<< "  --fused           play every game's whole episode in one go instead of frame by frame\n"
+		<< "  --unbatched       evaluate every agent's network on its own instead of batched per chunk of games\n"
+		<< "  --simultaneous    every agent observes the same frame, then all move and collide together\n"
+		<< "  --decision-interval K  run the networks every K frames, agents hold their last outputs in between\n"
+		<< "  --stagger         offset the deciding frames chunk by chunk of games to even out the load\n"
+		<< "  --early-stop      end games once their play has settled and extrapolate the learner's score\n"
+		<< "  --race            pick each generation's best network by successive halving over shorter games\n"
+		<< "  --steady-state    no generation barrier, every finished game gets a child of the elite straight away\n"
+		<< "  --es              train by evolution strategies (antithetic noise, rank weighted steps) instead of mutation,\n"
+		<< "                    not with --steady-state. the centre is saved as the best network and --load starts the\n"
+		<< "                    search over from it (the noise table comes back with the run seed, nothing else is kept)\n"
+		<< "  --ppo             train one gaussian policy by proximal policy optimisation instead of evolving, not with\n"
+		<< "                    --load: its value network, deviations and optimiser state are not saved\n"
+		<< "  --bench-threads   print the game steps per second for each thread count and exit\n"
+		<< "  --bench-modes     compare lockstep/fused, batched or not, sequential/simultaneous and exit\n"
+		<< "  --bench-network   check the simd forward pass against the scalar one, time both and exit\n"
+		<< "  --bench-physics   time collisions and nearest agent lookups, every pair vs the spatial grid, check that\n"
+		<< "                    both score and observe the same and exit\n"
+		<< "  --bench-decisions train --generations N (default 100) at decision intervals 1, 2, 4, 8 and exit\n"
+		<< "  --bench-early-stop  play --generations N (default 50) full length and with early termination, compare and exit\n"
+		<< "  --bench-race      train --generations N (default 50) with and without racing, score the picks on fresh starts and exit\n"
+		<< "  --bench-steady    train --generations N (default 50) by generations and steady state, compare and exit\n"
+		<< "  --bench-es        train --generations N (default 100) by mutation and by --es, score on fresh starts and exit\n"
+		<< "  --bench-ppo       train --minutes M (default 1) by mutation and by --ppo, time to a held out score of\n"
+		<< "                    --target S (default 1000) and exit\n"
+		<< "  --bench-league    train --generations N (default 300) drawing opponents alike and by pfsp, cross evaluate and exit\n"
+		<< "  --bench-archive   write --generations N (default 20000) networks to a snapshot archive, page some back in and exit\n";
+}
+
+
+struct Options
+{
+	unsigned generations = 0;
+	double minutes = 0;
+	unsigned threads = Simulation::threadsToUse();
+	std::string saveFile = "network_data.ckpt";
+	std::string exportFile{};
+	bool load = false;
+	bool autoSave = autoSaveByDefault;
+	bool fused = Settings::fusedEpisodes;
+	bool batched = Settings::batchedInference;
+	bool simultaneous = Settings::simultaneousTicks;
+	unsigned decisionInterval = Settings::decisionInterval;
+	bool stagger = Settings::staggerDecisions;
+	bool earlyStop = GameSettings::earlyTermination;
+	bool race = Settings::racing;
+	bool steadyState = Settings::steadyState;
+	bool strategies = Settings::evolutionStrategies;
+	bool ppo = Settings::proximalPolicy;
+	bool benchThreads = false;
+	bool benchModes = false;
+	bool benchNetwork = false;
+	bool benchPhysics = false;
+	bool benchDecisions = false;
+	bool benchEarlyStop = false;
+	bool benchRace = false;
+	bool benchSteady = false;
+	bool benchStrategies = false;
+	bool benchPpo = false;
+	bool benchLeague = false;
+	bool benchArchive = false;
+	float targetScore = 1000.f;
+	uint64_t seed = 0;
+	bool hasSeed = false;
+};
+
+
+// false (after printing the usage) on an option it does not know
+static bool parseArguments(const int argc, char* argv[], Options& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+
+		if (arg == "--generations" && hasValue)  options.generations = std::strtoul(argv[++i], nullptr, 10);
+		else if (arg == "--minutes" && hasValue) options.minutes = std::strtod(argv[++i], nullptr);
+		else if (arg == "--threads" && hasValue) options.threads = std::strtoul(argv[++i], nullptr, 10);
+		else if (arg == "--save" && hasValue)    options.saveFile = argv[++i];
+		else if (arg == "--seed" && hasValue)    { options.seed = std::strtoull(argv[++i], nullptr, 10); options.hasSeed = true; }
+		else if (arg == "--load")                options.load = true;
+		else if (arg == "--no-autosave")         options.autoSave = false;
+		else if (arg == "--export-json" && hasValue) options.exportFile = argv[++i];
+		else if (arg == "--fused")               options.fused = true;
+		else if (arg == "--unbatched")           options.batched = false;
+		else if (arg == "--simultaneous")        options.simultaneous = true;
+		else if (arg == "--decision-interval" && hasValue) options.decisionInterval = std::strtoul(argv[++i], nullptr, 10);
+		else if (arg == "--stagger")             options.stagger = true;
+		else if (arg == "--early-stop")          options.earlyStop = true;
+		else if (arg == "--race")                options.race = true;
+		else if (arg == "--steady-state")        options.steadyState = true;
+		else if (arg == "--es")                  options.strategies = true;
+		else if (arg == "--ppo")                 options.ppo = true;
+		else if (arg == "--bench-threads")       options.benchThreads = true;
+		else if (arg == "--bench-modes")         options.benchModes = true;
+		else if (arg == "--bench-network")       options.benchNetwork = true;
+		else if (arg == "--bench-physics")       options.benchPhysics = true;
+		else if (arg == "--bench-decisions")     options.benchDecisions = true;
+		else if (arg == "--bench-early-stop")    options.benchEarlyStop = true;
+		else if (arg == "--bench-race")          options.benchRace = true;
+		else if (arg == "--bench-steady")        options.benchSteady = true;
+		else if (arg == "--bench-es")            options.benchStrategies = true;
+		else if (arg == "--bench-ppo")           options.benchPpo = true;
+		else if (arg == "--bench-league")        options.benchLeague = true;
+		else if (arg == "--bench-archive")       options.benchArchive = true;
+		else if (arg == "--target" && hasValue)  options.targetScore = std::strtof(argv[++i], nullptr);
+		else
+		{
+			printUsage(argv[0]);
+			return false;
+		}
+	}
+	return true;
+}
+
+
+static void configure(Simulation& simulation, const Options& options)
+{
+	simulation.setSaveFile(options.saveFile);
+	simulation.setAutoSave(options.autoSave);
+	simulation.setFusedEpisodes(options.fused);
+	simulation.setBatchedInference(options.batched);
+	simulation.setSimultaneousTicks(options.simultaneous);
+	simulation.setDecisionInterval(options.decisionInterval, options.stagger);
+	simulation.setEarlyTermination(options.earlyStop);
+	simulation.setRacing(options.race);
+	simulation.setSteadyState(options.steadyState);
+	simulation.setEvolutionStrategies(options.strategies);
+	simulation.setProximalPolicy(options.ppo);
+}
+
+
+// runs the benchmark the options ask for and returns the exit code, nothing when they ask for none
+static std::optional<int> runBenchmark(const Options& options)
+{
+	if (options.benchNetwork)
+		return Simulation::benchmarkForwardPass() ? 0 : 1;
+
+	if (options.benchPhysics)
+		return Simulation::benchmarkPhysics() ? 0 : 1;
+
+	if (options.benchArchive)
+		return Simulation::benchmarkArchive(options.generations != 0 ? options.generations : 20'000) ? 0 : 1;
+
+	if (options.benchDecisions)
+	{
+		Simulation::benchmarkDecisionIntervals(options.threads, options.generations != 0 ? options.generations : 100, options.stagger);
+		return 0;
+	}
+
+	if (options.benchRace)
+	{
+		Simulation::benchmarkRacing(options.threads, options.generations != 0 ? options.generations : 50);
+		return 0;
+	}
+
+	if (options.benchSteady)
+	{
+		Simulation::benchmarkSteadyState(options.threads, options.generations != 0 ? options.generations : 50, options.earlyStop);
+		return 0;
+	}
+
+	if (options.benchStrategies)
+	{
+		Simulation::benchmarkEvolutionStrategies(options.threads, options.generations != 0 ? options.generations : 100);
+		return 0;
+	}
+
+	if (options.benchPpo)
+	{
+		Simulation::benchmarkProximalPolicy(options.threads, (options.minutes != 0 ? options.minutes : 1) * 60.0, options.targetScore);
+		return 0;
+	}
+
+	if (options.benchLeague)
+	{
+		Simulation::benchmarkLeague(options.threads, options.generations != 0 ? options.generations : 300);
+		return 0;
+	}
+
+	if (options.benchThreads || options.benchModes || options.benchEarlyStop)
+	{
+		Simulation simulation{ options.threads };
+		if (options.benchThreads)
+			simulation.benchmarkThreadCounts();
+		else if (options.benchModes)
+			simulation.benchmarkSteppingModes();
+		else
+		{
+			configure(simulation, options);
+			simulation.benchmarkEarlyTermination(options.generations != 0 ? options.generations : 50);
+		}
+		return 0;
+	}
+	return std::nullopt;
+}
+
+
+// parses the command line, then runs the benchmark it asks for or trains (after loading and exporting, if asked to)
+int Simulation::fromArguments(const int argc, char* argv[])
+{
+	Options options{};
+	if (!parseArguments(argc, argv, options))
+		return 1;
+
+	if (options.ppo && options.load)
+	{
+		std::cerr << "[error]: a --ppo run cannot be resumed, its value network, deviations and optimiser state are not saved\n";
+		return 1;
+	}
+
+	// has to happen before the simulation exists, the first networks are already drawn in its constructor
+	if (options.hasSeed)
+		RandomDist::setRunSeed(options.seed);
+	std::cout << "[notice]: run seed " << RandomDist::runSeed << "\n";
+
+	if (const std::optional<int> benchmarked = runBenchmark(options))
+		return *benchmarked;
+
+	Simulation simulation{ options.threads };
+	configure(simulation, options);
+	simulation.setRunLimits(options.generations, options.minutes * 60.0);
+
+	if (options.load && !simulation.loadNetworkData())
+	{
+		std::cerr << "[error]: could not resume from " << options.saveFile << "\n";
+		return 1;
+	}
+
+	if (!options.exportFile.empty())
+	{
+		simulation.exportNetworkData(options.exportFile);
+		return 0;
+	}
+
+	simulation.run();
+	return 0;
+}
@@ -1,14 +1,31 @@
 #include "simulation.hpp"
 #include <nlohmann/json.hpp>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <random>
 
-Simulation::Simulation() : DeltaTime(), scores(&m_window, 15)
+#ifndef HEADLESS
+Simulation::Simulation(const unsigned threads) : DeltaTime(), m_threadPool(std::make_unique<WorkStealingPool>(threads)), scores(&m_window, 15)
 {
-	m_window.setFramerateLimit((m_rendering == true) ? 100 : 999'999);
+	// only paces the window thread, the games are stepped as fast as the training thread can go
+	m_window.setFramerateLimit(snapshotRate);
 
+	RandomDist::seed(RandomDist::Init, 0, 0);
 	initGames();
 	initDebugGraphics();
 	printNetworkInfo();
 }
+#else
+Simulation::Simulation(const unsigned threads) : DeltaTime(), m_threadPool(std::make_unique<WorkStealingPool>(threads))
+{
+	m_rendering = false;
+
+	RandomDist::seed(RandomDist::Init, 0, 0);
+	initGames();
+	printNetworkInfo();
+}
+#endif
 
 
 void Simulation::printNetworkInfo()
@@ -30,9 +47,12 @@ void Simulation::printNetworkInfo()
 	std::cout << "Biases:  " << neurons << "\n";
 	std::cout << "weights: " << weights << "\n";
 	std::cout << "params:  " << weights + neurons << "\n";
+	std::cout << "kernel:  " << Simd::isaName() << "\n";
+	std::cout << "memory:  " << sizeof(NeuralNetwork) << " bytes per network\n";
 }
 
 
+#ifndef HEADLESS
 // creating the SFML shapes that will show debug information on the screen. the rest is handled by the vertex buffer
 void Simulation::initDebugGraphics()
 {
@@ -49,81 +69,529 @@ void Simulation::initDebugGraphics()
 	m_gameBorderRenderer.setFillColor({ 0, 0, 0, 0 });
 	m_gameBorderRenderer.setOutlineThickness(3.f);
 }
+#endif
 
 
 void Simulation::initGames()
 {
 	m_allGames.reserve(parrelelGames);
+	m_agents.resize(parrelelGames);
 
 	for (unsigned i = 0; i < parrelelGames; i++)
 	{
-		Game game{};
+		Game game{ &m_agents, i };
 		for (unsigned j = 0; j < GameSettings::agentsPergame; j++)
 		{
-			game.initAgent(Agent{ randPointInCircle(bounds) });
+			m_agents.setPosition(j, i, randPointInCircle(bounds));
 		}
 		m_allGames.push_back(game);
 	}
+
+	for (unsigned slot = 0; slot < GameSettings::agentsPergame; ++slot)
+		m_inference[slot].resize(parrelelGames, slot != 0);
+
+	for (unsigned i = 0; i < parrelelGames; i++)
+		syncInferenceWeights(i);
+	setOpponent(m_league.opponent(m_generationCount));
+	setDecisionInterval(m_decisionInterval, m_staggerDecisions);
+	setEarlyTermination(m_earlyTermination);
+
 	std::cout << "[notice]: "<< m_allGames.size() << " games created" << "\n";
 }
 
 
-void Simulation:: saveNetworkData()
+// the snapshot archive lives next to the save file, the first save moves the league's networks there. every run that
+// did not resume starts a file of its own (`<save>.<number>.snapshots`), the archive a checkpoint already there names
+// is never written over, a crash before the new checkpoint is on disk still leaves the old one whole. a resumed run
+// keeps the archive its checkpoint names and only appends past the records that checkpoint holds (League::resume)
+std::string Simulation::freshArchivePath() const
+{
+	std::random_device device{}; // not the run's rng, saving must not move its streams
+	std::filesystem::path path{};
+	do
+	{
+		path = std::filesystem::path(m_saveFile).replace_extension();
+		path += ".";
+		path += std::to_string(device());
+		path += ".snapshots";
+	}
+	while (std::filesystem::exists(path));
+	return path.string();
+}
+
+
+// the deltas saved on top of it, next to the checkpoint
+std::string Simulation::deltaLogPath() const
+{
+	return m_saveFile + ".delta";
+}
+
+
+// the first save moves the league's networks to the archive, every save asks for what was appended since to be
+// written back. false when the archive cannot be opened, the networks then go into every checkpoint
+bool Simulation::archiveLeague()
+{
+	if (!m_league.archive().mapped())
+		m_league.archiveTo(freshArchivePath());
+	m_league.archive().flush();
+	return m_league.archive().mapped();
+}
+
+
+// the checkpoint (see checkpoint.hpp) as it would be written now: the best network, the league's index and where
+// its networks are. it gets a new id, the deltas from here on go on top of it
+std::vector<char> Simulation::checkpointBytes()
+{
+	const bool archived = m_league.archive().mapped();
+	const std::string archiveName = archived ? std::filesystem::path(m_league.archive().path()).filename().string() : "";
+	const unsigned inlineNetworks = archived ? 0 : m_league.size();
+	constexpr uint64_t networkBytes = sizeof(float) * NeuralNetwork::parameterCount;
+
+	CheckpointHeader header = CheckpointHeader::make();
+	header.generation = m_generationCount;
+	header.runSeed = RandomDist::runSeed;
+	header.runTime = m_totalRunTime;
+	header.learnerRating = m_league.learnerRating();
+	header.latest = m_league.latest();
+	header.snapshots = m_league.size();
+	header.inlineNetworks = inlineNetworks;
+	header.bestOffset = CheckpointHeader::aligned(sizeof(CheckpointHeader));
+	header.indexOffset = CheckpointHeader::aligned(header.bestOffset + networkBytes);
+	header.networksOffset = CheckpointHeader::aligned(header.indexOffset + sizeof(League::Snapshot) * header.snapshots);
+	header.archiveOffset = CheckpointHeader::aligned(header.networksOffset + networkBytes * inlineNetworks);
+	header.archiveLength = archiveName.size();
+	std::random_device device{}; // not the run's rng, saving must not move its streams
+	do
+		header.id = (static_cast<uint64_t>(device()) << 32) ^ device();
+	while (header.id == 0);
+
+	std::vector<char> bytes(header.archiveOffset + header.archiveLength, 0);
+	std::memcpy(bytes.data(), &header, sizeof(header));
+	std::memcpy(bytes.data() + header.bestOffset, m_bestNetwork.parameterSpan().data(), networkBytes);
+	std::memcpy(bytes.data() + header.indexOffset, m_league.snapshots().data(), sizeof(League::Snapshot) * header.snapshots);
+	for (unsigned i = 0; i < inlineNetworks; ++i)
+		std::memcpy(bytes.data() + header.networksOffset + networkBytes * i, m_league.network(i).parameterSpan().data(), networkBytes);
+	std::memcpy(bytes.data() + header.archiveOffset, archiveName.data(), archiveName.size());
+
+	m_league.takeChanged();
+	m_checkpointId = archived ? header.id : 0; // networks that are not archived cannot be added by a delta
+	m_deltaSequence = 0;
+	m_checkpointSize = bytes.size();
+	m_deltaLogSize = 0;
+	return bytes;
+}
+
+
+// the delta (see CheckpointDelta) on top of the last checkpoint and the deltas after it
+std::vector<char> Simulation::checkpointDelta()
+{
+	const std::vector<unsigned> changed = m_league.takeChanged();
+
+	CheckpointDelta delta{};
+	std::memcpy(delta.magic, CheckpointDelta::file_magic, sizeof(delta.magic));
+	delta.base = m_checkpointId;
+	delta.sequence = m_deltaSequence++;
+	delta.bytes = static_cast<uint32_t>(CheckpointDelta::size(changed.size()));
+	delta.generation = m_generationCount;
+	delta.latest = m_league.latest();
+	delta.runSeed = RandomDist::runSeed;
+	delta.runTime = m_totalRunTime;
+	delta.learnerRating = m_league.learnerRating();
+	delta.snapshots = m_league.size();
+	delta.changed = static_cast<uint32_t>(changed.size());
+
+	std::vector<char> bytes(delta.bytes, 0);
+	std::memcpy(bytes.data() + CheckpointDelta::bestOffset(), m_bestNetwork.parameterSpan().data(), sizeof(float) * NeuralNetwork::parameterCount);
+	for (unsigned i = 0; i < changed.size(); ++i)
+	{
+		const CheckpointDelta::Entry entry{ changed[i], m_league.snapshots()[changed[i]] };
+		std::memcpy(bytes.data() + CheckpointDelta::entriesOffset() + sizeof(entry) * i, &entry, sizeof(entry));
+	}
+	std::memcpy(bytes.data(), &delta, sizeof(delta));
+	delta.checksum = CheckpointDelta::hash(bytes.data(), bytes.size());
+	std::memcpy(bytes.data(), &delta, sizeof(delta));
+
+	m_deltaLogSize += bytes.size();
+	return bytes;
+}
+
+
+// only the copy is made here, the league's networks are already in the archive and are never written to again
+// (appends go past the copied index), so nothing else has to be held still while the writer thread writes it. a
+// save is a delta until the log has grown as big as the checkpoint under it, or until a write fails
+void Simulation::saveNetworkData()
 {
 	std::cout << "[Notice]: Saving. . .\n";
+	if (m_checkpointWriter.failed())
+		m_checkpointId = 0;
+
+	const bool archived = archiveLeague();
+	const std::string archive = archived ? m_league.archive().path() : "";
+	if (archived && m_checkpointId != 0 && m_deltaLogSize < m_checkpointSize)
+		m_checkpointWriter.append(deltaLogPath(), checkpointDelta(), archive);
+	else
+		m_checkpointWriter.submit(m_saveFile, checkpointBytes(), deltaLogPath(), archive);
+}
+
 
-	nlohmann::json agent_networks = {};
-	for (unsigned i = 0; i < GameSettings::agentsPergame; i++)
+// the same as the checkpoint, as json and with every network written out, for reading it with anything else.
+// loadNetworkData() reads it back
+void Simulation::exportNetworkData(const std::string& file)
+{
+	nlohmann::json ratings = nlohmann::json::array();
+	nlohmann::json games = nlohmann::json::array();
+	nlohmann::json generations = nlohmann::json::array();
+	nlohmann::json scores = nlohmann::json::array();
+	nlohmann::json agent_networks = nlohmann::json::array();
+	for (unsigned i = 0; i < m_league.size(); ++i)
 	{
-		for (NeuralNetwork& network : selfRL.policy)
-			network.jsonFormat(agent_networks);
+		const League::Snapshot& snapshot = m_league.snapshots()[i];
+		ratings.push_back(snapshot.rating);
+		games.push_back(snapshot.games);
+		generations.push_back(snapshot.generation);
+		scores.push_back(snapshot.score);
+		m_league.network(i).jsonFormat(agent_networks);
 	}
 
+	nlohmann::json best = nlohmann::json::array();
+	m_bestNetwork.jsonFormat(best);
+
 	const nlohmann::json data = {
-		{"gen", m_generationCount},
+		{"gen", m_generationCount.load()},
 		{"time", m_totalRunTime},
-		{"nets", agent_networks}
+		{"seed", RandomDist::runSeed.load()},
+		{"best", best[0]},
+		{"nets", agent_networks},
+		{"league", {
+			{"ratings", ratings},
+			{"games", games},
+			{"generations", generations},
+			{"scores", scores},
+			{"latest", m_league.latest()},
+			{"learner_rating", m_league.learnerRating()}
+		}}
 	};
 
-	std::ofstream ofs("network_data.json");
+	std::ofstream ofs(file);
 	ofs << data.dump(3);
 	ofs.close();
+	std::cout << "[notice]: exported " << m_league.size() << " networks to " << file << "\n";
 }
 
-void Simulation::loadNetworkData()
+
+// reads one network in jsonFormat()'s layout into `network`, false when its layers are not this build's shape. a
+// value that is not a number throws nlohmann::json::type_error
+static bool networkFromJson(const nlohmann::json& saved, NeuralNetwork& network)
 {
-	// reading data from file
-	nlohmann::json simulationData = loadJsonData("network_data.json");
-	m_generationCount = simulationData["gen"];
-	m_totalRunTime = simulationData["time"];
+	if (!saved.is_object() || !saved.contains("weights") || !saved.contains("biases"))
+		return false;
+	const nlohmann::json& agentWeights = saved["weights"];
+	const nlohmann::json& agentBiases = saved["biases"];
+	if (!agentWeights.is_array() || agentWeights.size() != NetSettings::NetworkLayers - 1 || !agentBiases.is_array() || agentBiases.size() != NetSettings::NetworkLayers - 1)
+		return false;
+
+	for (unsigned layer = 0; layer < NetSettings::NetworkLayers - 1; ++layer) // each network layer
+	{
+		const nlohmann::json& nodes = agentWeights[layer];
+		const nlohmann::json& biases = agentBiases[layer];
+		if (!nodes.is_array() || nodes.size() != NetSettings::NN_dims[layer + 1] || !biases.is_array() || biases.size() != NetSettings::NN_dims[layer + 1])
+			return false;
+
+		for (unsigned node = 0; node < NetSettings::NN_dims[layer + 1]; ++node)
+		{
+			const nlohmann::json& weights = nodes[node];
+			if (!weights.is_array() || weights.size() != NetSettings::NN_dims[layer])
+				return false;
+
+			for (unsigned weight = 0; weight < NetSettings::NN_dims[layer]; ++weight)
+			{
+				network.weight(layer, node, weight) = weights[weight].get<float>();
+			}
+		}
+
+		for (unsigned bias = 0; bias < NetSettings::NN_dims[layer + 1]; ++bias)
+		{
+			network.bias(layer, bias) = biases[bias].get<float>();
+		}
+	}
+	return true;
+}
 
-	// shrinking variable names
-	constexpr unsigned total_nets = ReinforcementLearning::snapshot_window;
 
-	selfRL.reset_information();
+// replays the deltas in the log at `path` that go on top of the checkpoint `header` (the counters in it are
+// moved on to the last one) over `snapshots` and `best`. stops at the first one that is torn, belongs to another
+// checkpoint or does not fit the index, returns the bytes of the log it used and counts the deltas in `sequence`
+static uint64_t replayDeltas(const std::string& path, CheckpointHeader& header, std::vector<League::Snapshot>& snapshots, NeuralNetwork& best, uint32_t& sequence)
+{
+	sequence = 0;
+	MappedFile log{};
+	if (!log.open(path, MappedFile::Read))
+		return 0; // no delta since the checkpoint
 
-	for (unsigned network_i = 0; network_i < total_nets; network_i++)
+	uint64_t offset = 0;
+	while (CheckpointDelta::valid(log.data() + offset, log.size() - offset, header.id, sequence))
 	{
-		std::vector<std::vector<std::vector<float>>> agentWeights = simulationData["nets"][network_i]["weights"];
-		std::vector<std::vector<float>> agentBiases = simulationData["nets"][network_i]["biases"];
+		const char* record = log.data() + offset;
+		CheckpointDelta delta{};
+		std::memcpy(&delta, record, sizeof(delta));
 
-		for (unsigned layer = 0; layer < NetSettings::NetworkLayers - 1; ++layer) // each network layer
+		std::vector<League::Snapshot> replayed = snapshots;
+		bool fits = true;
+		for (unsigned i = 0; i < delta.changed && fits; ++i)
+		{
+			CheckpointDelta::Entry entry{};
+			std::memcpy(&entry, record + CheckpointDelta::entriesOffset() + sizeof(entry) * i, sizeof(entry));
+			if (entry.slot < replayed.size())
+				replayed[entry.slot] = entry.snapshot;
+			else if (entry.slot == replayed.size())
+				replayed.push_back(entry.snapshot);
+			else
+				fits = false;
+		}
+		if (!fits || replayed.size() != delta.snapshots)
 		{
-			for (unsigned node = 0; node < NetSettings::NN_dims[layer + 1]; ++node)
+			std::cerr << "[error]: delta " << sequence << " in " << path << " does not fit the league, replaying stopped there\n";
+			break;
+		}
+
+		snapshots = std::move(replayed);
+		std::memcpy(best.parameterSpan().data(), record + CheckpointDelta::bestOffset(), sizeof(float) * NeuralNetwork::parameterCount);
+		header.generation = delta.generation;
+		header.latest = delta.latest;
+		header.runSeed = delta.runSeed;
+		header.runTime = delta.runTime;
+		header.learnerRating = delta.learnerRating;
+		header.snapshots = delta.snapshots;
+		offset += delta.bytes;
+		++sequence;
+	}
+	return offset;
+}
+
+
+// maps the checkpoint and takes everything straight out of the mapping, only the league's index is copied (into the
+// league) and the best network's parameters, then replays the deltas saved since. anything that is not a checkpoint
+// is read as json. false (and the run left as it was, but for a league of inline networks cut short) when the save
+// cannot be read
+bool Simulation::loadNetworkData()
+{
+	m_checkpointWriter.wait(); // a save still being written is the newest checkpoint
+
+	if (m_proximalPolicy)
+	{
+		std::cerr << "[error]: a ppo run cannot be resumed, its value network, deviations and optimiser state are not saved\n";
+		return false;
+	}
+
+	MappedFile file{};
+	if (!file.open(m_saveFile, MappedFile::Read))
+	{
+		std::cerr << "[error]: cannot open " << m_saveFile << "\n";
+		return false;
+	}
+
+	if (file.size() < sizeof(CheckpointHeader) || !reinterpret_cast<const CheckpointHeader*>(file.data())->isCheckpoint())
+	{
+		file.close();
+		return importNetworkData();
+	}
+	CheckpointHeader header = *reinterpret_cast<const CheckpointHeader*>(file.data());
+	if (header.version < 2)
+		header.id = 0; // version 1 ended where the id is
+
+	constexpr uint64_t networkBytes = sizeof(float) * NeuralNetwork::parameterCount;
+	if (!header.fits())
+	{
+		std::cerr << "[error]: " << m_saveFile << " was written by another version or for another network shape\n";
+		return false;
+	}
+	if (!header.inside(file.size()))
+	{
+		std::cerr << "[error]: " << m_saveFile << " is cut short or damaged, its header points past the end of it\n";
+		return false;
+	}
+
+	const auto* index = reinterpret_cast<const League::Snapshot*>(file.data() + header.indexOffset);
+	std::vector<League::Snapshot> snapshots(index, index + header.snapshots);
+	NeuralNetwork network{ m_bestNetwork }; // copied, a new network would draw its weights
+	std::memcpy(network.parameterSpan().data(), file.data() + header.bestOffset, networkBytes);
+	NeuralNetwork best{ network };
+
+	uint32_t deltas = 0;
+	const uint64_t logSize = header.id != 0 && header.inlineNetworks == 0 ? replayDeltas(deltaLogPath(), header, snapshots, best, deltas) : 0;
+
+	if (header.inlineNetworks == 0)
+	{
+		const std::string archiveName(file.data() + header.archiveOffset, header.archiveLength);
+		const std::filesystem::path archive = std::filesystem::path(m_saveFile).parent_path() / archiveName;
+		if (!m_league.resume(archive.string(), snapshots))
+			return false;
+	}
+	else
+	{
+		std::vector<NeuralNetwork> networks(header.inlineNetworks, network);
+		for (unsigned i = 0; i < header.inlineNetworks; ++i)
+			std::memcpy(networks[i].parameterSpan().data(), file.data() + header.networksOffset + networkBytes * i, networkBytes);
+		snapshots.resize(header.inlineNetworks);
+		if (!m_league.replace(networks, snapshots))
+			return false;
+	}
+
+	// the next save is the delta after the last one replayed. a log with anything past that (a torn delta) is not
+	// appended to, the next save is a checkpoint and starts it over
+	std::error_code error{};
+	const uint64_t logFileSize = std::filesystem::file_size(deltaLogPath(), error);
+	const bool wholeLog = error ? logSize == 0 : logFileSize == logSize;
+	m_checkpointId = header.inlineNetworks == 0 && wholeLog ? header.id : 0;
+	m_deltaSequence = deltas;
+	m_checkpointSize = file.size();
+	m_deltaLogSize = logSize;
+
+	m_generationCount = header.generation;
+	m_totalRunTime = header.runTime;
+	m_league.setLatest(header.latest);
+	m_league.setLearnerRating(header.learnerRating);
+	RandomDist::setRunSeed(header.runSeed);
+	std::cout << "[notice]: resuming gen " << header.generation << " of run seed " << header.runSeed;
+	if (deltas != 0)
+		std::cout << " (" << deltas << " deltas on top of the checkpoint)";
+	std::cout << "\n";
+
+	resumeFrom(&best);
+	return true;
+}
+
+
+// json saves: exports, saves from before the checkpoint (naming their snapshot archive or holding the networks
+// themselves) and saves from before the league, which held the last 10 snapshots (twice over) and no ratings, those
+// all start out even. everything is read and checked before anything is replaced, false (and the run left as it
+// was) when the file is not json, not a save, or holds networks of another shape
+bool Simulation::importNetworkData()
+{
+	nlohmann::json simulationData{};
+	std::vector<League::Snapshot> index{};
+	std::vector<NeuralNetwork> networks{};
+	std::filesystem::path archivePath{};
+	std::optional<NeuralNetwork> best{};
+	unsigned generation = 0;
+	double runTime = 0;
+	unsigned latest = 0;
+	float learnerRating = League::initial_rating;
+	std::optional<uint64_t> runSeed{};
+	const auto refuse = [this]
+	{
+		std::cerr << "[error]: " << m_saveFile << " is not a save of this network's shape\n";
+		return false;
+	};
+
+	try
+	{
+		simulationData = loadJsonData(m_saveFile);
+		if (!simulationData.is_object() || !simulationData.contains("gen") || !simulationData.contains("time")
+			|| (!simulationData.contains("archive") && !simulationData.contains("nets")))
+			return refuse();
+
+		const bool rated = simulationData.contains("league");
+		if (rated)
+		{
+			const nlohmann::json& league = simulationData["league"];
+			if (!league.is_object() || !league.contains("ratings") || !league.contains("games") || !league.contains("generations")
+				|| !league.contains("latest") || !league.contains("learner_rating"))
+				return refuse();
+
+			const nlohmann::json& ratings = league["ratings"];
+			const size_t size = ratings.size();
+			if (!ratings.is_array() || !league["games"].is_array() || league["games"].size() != size
+				|| !league["generations"].is_array() || league["generations"].size() != size
+				|| (league.contains("scores") && (!league["scores"].is_array() || league["scores"].size() != size)))
+				return refuse();
+
+			for (unsigned i = 0; i < size; ++i)
 			{
-				for (unsigned weight = 0; weight < NetSettings::NN_dims[layer]; ++weight)
-				{
-					selfRL.policy[selfRL.current_index].weights[layer][node][weight] = agentWeights[layer][node][weight];
-				}
+				const float score = league.contains("scores") ? league["scores"][i].get<float>() : 0.f;
+				index.push_back({ ratings[i].get<float>(), league["games"][i].get<unsigned>(), league["generations"][i].get<unsigned>(), score });
 			}
+			latest = league["latest"].get<unsigned>();
+			learnerRating = league["learner_rating"].get<float>();
+		}
+
+		if (simulationData.contains("archive"))
+			archivePath = std::filesystem::path(m_saveFile).parent_path() / simulationData["archive"].get<std::string>();
+		else
+		{
+			constexpr unsigned oldWindow = 10;
+			const nlohmann::json& nets = simulationData["nets"];
+			if (!nets.is_array() || (rated && nets.size() < index.size()))
+				return refuse();
 
-			for (unsigned bias = 0; bias < NetSettings::NN_dims[layer + 1]; ++bias)
+			const unsigned count = rated ? static_cast<unsigned>(index.size()) : std::min(oldWindow, static_cast<unsigned>(nets.size()));
+			for (unsigned network_i = 0; network_i < count; network_i++)
 			{
-				selfRL.policy[selfRL.current_index].biases[layer][bias] = agentBiases[layer][bias];
+				networks.push_back(m_bestNetwork); // copied, a new network would draw its weights
+				if (!networkFromJson(nets[network_i], networks.back()))
+					return refuse();
 			}
+			if (!rated)
+				index.assign(count, League::Snapshot{});
+		}
+
+		if (simulationData.contains("best"))
+		{
+			best.emplace(m_bestNetwork);
+			if (!networkFromJson(simulationData["best"], *best))
+				return refuse();
 		}
 
-		selfRL.increment();
+		generation = simulationData["gen"].get<unsigned>();
+		runTime = simulationData["time"].get<double>();
+		if (simulationData.contains("seed"))
+			runSeed = simulationData["seed"].get<uint64_t>();
+	}
+	catch (const nlohmann::json::exception& error)
+	{
+		std::cerr << "[error]: " << m_saveFile << " cannot be read: " << error.what() << "\n";
+		return false;
 	}
+
+	if (!archivePath.empty() ? !m_league.resume(archivePath.string(), index) : !m_league.replace(networks, index))
+		return false;
+
+	m_generationCount = generation;
+	m_totalRunTime = runTime;
+	if (simulationData.contains("league"))
+	{
+		m_league.setLatest(latest);
+		m_league.setLearnerRating(learnerRating);
+	}
+	if (runSeed)
+		RandomDist::setRunSeed(*runSeed);
+	m_checkpointId = 0; // the next save is a checkpoint
+	std::cout << "[notice]: resuming gen " << m_generationCount << " of run seed " << RandomDist::runSeed << "\n";
+
+	resumeFrom(best ? &*best : nullptr);
+	return true;
+}
+
+
+// the last generation's games were already recorded against the league that was just replaced, so they sit out.
+// with the saved best network every learner is that network, prepareNextAgents() then breeds the next generation
+// from it. saves without one carry on from the networks the games have
+void Simulation::resumeFrom(const NeuralNetwork* best)
+{
+	for (unsigned i = 0; i < parrelelGames; ++i)
+	{
+		m_allGames[i].sitOut();
+		if (best != nullptr)
+		{
+			m_allGames[i].learner = *best;
+			syncInferenceWeights(i);
+		}
+	}
+
+	// the games sat out, there are no scores to step the centre by. the search starts over from the best network,
+	// with evolution strategies that is the centre the checkpoint saved
+	m_strategies.restart();
+	m_racers.clear(); // no race was run on the games that sat out
+	m_raceFrames = 0;
 	prepareNextAgents();
-}
\ No newline at end of file
+}
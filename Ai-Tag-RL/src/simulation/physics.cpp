@@ -1,101 +1,588 @@
 #include "simulation.hpp"
 
+#include <numeric>
 
-void Simulation::runGame(Game* game)
+
+// plays a whole episode in one tight loop, nothing outside of this game is touched until it is over
+void Simulation::runGame(Game* game, const bool simultaneous)
+{
+	while (!game->tick(simultaneous)) {}
+}
+
+
+void Simulation::run()
 {
-	for (unsigned i = 0; i < GameSettings::gameFrameLength; i++)
+	noticeOverriddenModes();
+#ifdef HEADLESS
+	trainingLoop();
+#else
+	// the games are stepped on their own thread while this (the window's) thread only draws the snapshots
+	// they publish, so watching the training never slows it down
+	std::thread trainingThread([this] { trainingLoop(); });
+	uihandeling();
+
+	m_closeSim = true;
+	trainingThread.join();
+#endif
+}
+
+
+// the training modes do not all combine: ppo trains one policy instead of evolving, steady state breeds by mutation
+// and neither it nor evolution strategies races. says which of the modes asked for will do nothing
+void Simulation::noticeOverriddenModes() const
+{
+	if (m_proximalPolicy)
 	{
-		game->tick();
+		if (m_racing || m_steadyState || m_evolutionStrategies)
+			std::cout << "[notice]: ppo trains one policy, --race, --steady-state and --es do nothing with it\n";
+		return;
 	}
+
+	if (m_steadyState && m_evolutionStrategies)
+		std::cout << "[notice]: steady state evolution breeds by mutation, --es does nothing with it\n";
+	if (m_racing && (m_steadyState || m_evolutionStrategies))
+		std::cout << "[notice]: " << (m_steadyState ? "steady state evolution" : "evolution strategies") << " does not race, --race does nothing with it\n";
 }
 
 
-void Simulation::uihandeling()
+void Simulation::trainingLoop()
 {
-	for (unsigned i = 0; i < GameSettings::gameFrameLength; i++)
+	while (!m_closeSim)
 	{
-		pollEvents();
-		endFrame();
-		setWindowTitle();
+		processUiRequests();
+		if (steadyRunning())
+		{
+			runSteadyState(); // does its own generations, returns on closing or when a checkpoint is to be loaded
+			continue;
+		}
 
-		if (m_rendering == true)
-			renderFrame();
+		// evolution strategies needs every game's score from the same start, it does not race. neither does ppo, whose
+		// games are not candidates but samples of the one policy
+		if (m_proximalPolicy)
+			runRollout();
+		else if (racesGenerations())
+			runRace();
+		else
+		{
+			resetGames();
+			runGeneration();
+		}
+		prepareNextAgents();
+		endOfGenStats();
 	}
 }
 
 
-void Simulation::run()
+void Simulation::runGeneration()
 {
-	while (!m_closeSim)
+	if (m_fusedEpisodes)
+		runGenerationFused();
+	else
+		runGenerationLockstep();
+}
+
+
+// successive halving: every candidate plays a quarter length slice (with raceRounds = 4), the worse half sits out the
+// rest of the generation and the survivors play twice as many frames the next round, each round from a fresh start.
+// past gameFrameLength a round is split into several full length episodes rather than one long game. every round
+// costs about as many frames as the first, so the race as a whole costs about as much as one full length generation,
+// but the network picked has played the most frames from the most starts. candidates are ranked by their score summed
+// over every round so far, which every survivor played the same frames for
+void Simulation::runRace()
+{
+	constexpr unsigned baseFrames = GameSettings::gameFrameLength / raceRounds;
+
+	m_racers.resize(parrelelGames);
+	std::iota(m_racers.begin(), m_racers.end(), 0u);
+	m_raceScores.assign(parrelelGames, 0.f);
+	m_raceFrames = 0;
+
+	unsigned episode = 0;
+	for (unsigned round = 0; round < raceRounds && !m_closeSim; ++round)
 	{
-		resetGames();
-		bool stop = false;
-		while (!stop && !m_closeSim)
+		const unsigned roundFrames = baseFrames << round;
+		const unsigned episodes = (roundFrames + GameSettings::gameFrameLength - 1) / GameSettings::gameFrameLength;
+
+		for (unsigned e = 0; e < episodes; ++e, ++episode)
 		{
-			if (!m_paused)
+			resetGames(episode, roundFrames / episodes);
+			for (unsigned i = 0, racer = 0; i < parrelelGames; ++i)
 			{
-				for (Game& game : m_allGames)
-				{
-					stop = game.tick();
-				}
+				if (racer < m_racers.size() && m_racers[racer] == i)
+					++racer;
+				else
+					m_allGames[i].sitOut();
 			}
 
-			if (fastForward) m_rendering = false;
+			runGeneration();
+			m_genSkipped += framesSkipped();
 
+			for (const unsigned i : m_racers)
+				m_raceScores[i] += m_agents.score[m_agents.index(0, i)];
+			m_raceFrames += roundFrames / episodes;
+		}
 
-			if (m_rendering || (!m_rendering && m_totalFrameCount % 2000 == 0))
-			{
-				pollEvents();
-				endFrame();
-				setWindowTitle();
-			}
+		if (round + 1 == raceRounds)
+			break;
+
+		// lowest score first, the lower game index first on a tie, then back in game order for the next round
+		std::sort(m_racers.begin(), m_racers.end(), [this](const unsigned a, const unsigned b)
+		{
+			return m_raceScores[a] != m_raceScores[b] ? m_raceScores[a] < m_raceScores[b] : a < b;
+		});
+		m_racers.resize((m_racers.size() + 1) / 2);
+		std::sort(m_racers.begin(), m_racers.end());
+	}
+}
 
-			if (m_rendering == true)
-				renderFrame();
 
-			++m_totalFrameCount;
+// every game takes one frame, then the ui flags are checked and game 0 is published, then the next frame...
+void Simulation::runGenerationLockstep()
+{
+	bool stop = false;
+	while (!stop && !m_closeSim)
+	{
+		if (m_paused)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			continue;
 		}
-		if (fastForward) { fastForward = false; m_rendering = true; }
-		prepareNextAgents();
-		endOfGenStats();
+
+		tickGames(stop);
+		publishSnapshot();
+
+		++m_totalFrameCount;
+	}
+}
+
+
+// every game plays its whole episode on one worker in one go (runGame), so that game's agents and networks stay
+// hot in that core's cache for all gameFrameLength ticks. pausing and closing are only looked at between generations
+void Simulation::runGenerationFused()
+{
+	while (m_paused && !m_closeSim)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	m_threadPool->parallelFor(parrelelGames, episodeChunk(), [this](const unsigned begin, const unsigned end, unsigned)
+	{
+		playEpisodes(begin, end);
+	});
+
+	m_genSteps += framesPlayed();
+	m_totalFrameCount += std::max_element(m_allGames.begin(), m_allGames.end(), [](const Game& a, const Game& b) { return a.frameLength < b.frameLength; })->frameLength;
+}
+
+
+// games are big units of work when each plays its whole episode, so without batching they are handed out one at a
+// time for the best stealing. with batching a chunk of games plays its episodes side by side so every frame is one
+// batched forward pass
+unsigned Simulation::episodeChunk() const
+{
+	return m_batchedInference ? gamesPerChunk : 1;
+}
+
+
+// plays the episodes of games [begin, end) to the end, games that are not playing are left alone
+void Simulation::playEpisodes(const unsigned begin, const unsigned end)
+{
+	if (m_batchedInference)
+	{
+		while (std::any_of(m_allGames.begin() + begin, m_allGames.begin() + end, [](const Game& game) { return game.playing(); }))
+		{
+			tickGameRange(begin, end);
+			if (begin == 0)
+				publishSnapshot();
+		}
+		return;
+	}
+
+	for (unsigned i = begin; i < end; ++i)
+	{
+		if (!m_allGames[i].playing())
+			continue;
+
+		if (i == 0)
+			runWatchedGame();
+		else
+			runGame(&m_allGames[i], m_simultaneousTicks);
+	}
+}
+
+
+// game 0 is the one on screen, the worker playing it is the only one publishing snapshots during a fused generation
+void Simulation::runWatchedGame()
+{
+	Game& game = m_allGames[0];
+	bool over = false;
+	while (!over)
+	{
+		over = game.tick(m_simultaneousTicks);
+		publishSnapshot();
+	}
+}
+
+
+// calls run(first, last) for every stretch of consecutive games in [begin, end) that pass `test`
+template<typename Test, typename Run>
+static void forRunsOf(const std::vector<Game>& games, const unsigned begin, const unsigned end, Test&& test, Run&& run)
+{
+	for (unsigned first = begin; first < end;)
+	{
+		if (!test(games[first]))
+		{
+			++first;
+			continue;
+		}
+
+		unsigned last = first + 1;
+		while (last < end && test(games[last]))
+			++last;
+
+		run(first, last);
+		first = last;
+	}
+}
+
+// the games in [begin, end) whose networks run this frame
+template<typename Run>
+static void forDecidingGames(const std::vector<Game>& games, const unsigned begin, const unsigned end, Run&& run)
+{
+	forRunsOf(games, begin, end, [](const Game& game) { return game.decides(); }, std::forward<Run>(run));
+}
+
+
+// steps games [begin, end) by one frame. with batched inference every agent slot is done for the whole range at once:
+// gather the inputs, one batched forward pass, then move the agents. slots go one after another so agent 1 still
+// sees where agent 0 has just moved to, exactly like Game::tick. with simultaneous ticks every slot's pass runs on the
+// same frame, then all agents move and one resolve pass handles the collisions. games that are not deciding this
+// frame skip the inputs and the forward pass, their rows still hold the last outputs. games that already ended
+// early are left alone
+void Simulation::tickGameRange(const unsigned begin, const unsigned end)
+{
+	if (!m_batchedInference)
+	{
+		for (unsigned i = begin; i < end; ++i)
+		{
+			if (m_allGames[i].playing())
+				m_allGames[i].tick(m_simultaneousTicks);
+		}
+		return;
 	}
+
+	forRunsOf(m_allGames, begin, end, [](const Game& game) { return game.playing(); }, [this](const unsigned first, const unsigned last)
+	{
+		tickBatchedRange(first, last);
+	});
+}
+
+
+// tickGameRange() with batched inference for games [begin, end), which are all still playing
+void Simulation::tickBatchedRange(const unsigned begin, const unsigned end)
+{
+	if (m_simultaneousTicks)
+	{
+		for (unsigned slot = 0; slot < GameSettings::agentsPergame; ++slot)
+		{
+			forDecidingGames(m_allGames, begin, end, [&](const unsigned first, const unsigned last)
+			{
+				for (unsigned i = first; i < last; ++i)
+					m_agents.setNetworkInputs(slot, i, m_inference[slot].inputs(i));
+			});
+		}
+
+		for (unsigned slot = 0; slot < GameSettings::agentsPergame; ++slot)
+		{
+			forDecidingGames(m_allGames, begin, end, [&](const unsigned first, const unsigned last)
+			{
+				m_inference[slot].compute(first, last);
+			});
+			m_agents.integrate(slot, begin, end, m_inference[slot].outputs(begin), BatchedInference::outputStride);
+		}
+
+		m_agents.resolve(begin, end);
+
+		for (unsigned i = begin; i < end; ++i)
+			m_allGames[i].countDown();
+		return;
+	}
+
+	for (unsigned slot = 0; slot < GameSettings::agentsPergame; ++slot)
+	{
+		BatchedInference& inference = m_inference[slot];
+
+		forDecidingGames(m_allGames, begin, end, [&](const unsigned first, const unsigned last)
+		{
+			for (unsigned i = first; i < last; ++i)
+				m_agents.setNetworkInputs(slot, i, inference.inputs(i));
+
+			inference.compute(first, last);
+		});
+
+		m_agents.act(slot, begin, end, inference.outputs(begin), BatchedInference::outputStride);
+	}
+
+	for (unsigned i = begin; i < end; ++i)
+		m_allGames[i].countDown();
+}
+
+
+// the networks of every game run every `interval` frames. staggered, each chunk of games is offset by one more frame
+// than the last, so any one frame only runs about 1/interval of the networks instead of all or none of them
+void Simulation::setDecisionInterval(const unsigned interval, const bool staggered)
+{
+	m_decisionInterval = std::max(interval, 1u);
+	m_staggerDecisions = staggered;
+
+	for (unsigned i = 0; i < parrelelGames; ++i)
+	{
+		m_allGames[i].decisionInterval = m_decisionInterval;
+		m_allGames[i].decisionOffset = staggered ? (i / gamesPerChunk) % m_decisionInterval : 0;
+	}
+}
+
+
+// games end as soon as they settle from now on, see Game::endIfSettled()
+void Simulation::setEarlyTermination(const bool enabled)
+{
+	m_earlyTermination = enabled;
+	for (Game& game : m_allGames)
+		game.earlyTermination = enabled;
+}
+
+
+unsigned long long Simulation::framesSkipped() const
+{
+	unsigned long long frames = 0;
+	for (const Game& game : m_allGames)
+		frames += game.framesSkipped;
+	return frames;
+}
+
+
+unsigned long long Simulation::framesPlayed() const
+{
+	unsigned long long frames = 0;
+	for (const Game& game : m_allGames)
+		frames += game.framesPlayed();
+	return frames;
+}
+
+
+// only the learner slot holds a copy per game, the opponent slots read the shared network (setOpponent)
+void Simulation::syncInferenceWeights(const unsigned game)
+{
+	m_inference[0].loadWeights(game, m_allGames[game].learner);
+}
+
+
+// every game plays the same read-only opponent from the league, nothing is copied
+void Simulation::setOpponent(const NeuralNetwork* opponent)
+{
+	for (Game& game : m_allGames)
+		game.opponent = opponent;
+
+	for (unsigned slot = 1; slot < GameSettings::agentsPergame; ++slot)
+		m_inference[slot].shareWeights(opponent);
+}
+
+
+// saving and loading touch the league, so requests from the window thread wait for the generation boundary. a load
+// that fails turns autosaving off, the next autosave would write over the save that could not be read
+void Simulation::processUiRequests()
+{
+	if (m_saveRequested.exchange(false))
+		saveNetworkData();
+
+	if (m_loadRequested.exchange(false) && !loadNetworkData() && m_auto_save)
+	{
+		std::cerr << "[notice]: autosave is off, " << m_saveFile << " is left as it is\n";
+		m_auto_save = false;
+	}
+}
+
+
+// copies game 0 out for the renderer, at most `snapshotRate` times a second
+void Simulation::publishSnapshot()
+{
+	const auto now = std::chrono::steady_clock::now();
+	if (now - m_lastSnapshot < std::chrono::microseconds(1'000'000 / snapshotRate))
+		return;
+
+	m_lastSnapshot = now;
+	m_gameSnapshots.publish([this](GameSnapshot& snapshot)
+	{
+		m_allGames[0].takeSnapshot(snapshot);
+		snapshot.generation = m_generationCount;
+	});
 }
 
 
 void Simulation::prepareNextAgents()
 {
+	RandomDist::seed(RandomDist::Evolution, m_generationCount, 0);
+
+	recordLeagueResults();
 	getTopNet();
-	const NeuralNetwork* bestNetwork = best_net_info.Network;
-	selfRL.add_neural_network(*bestNetwork, m_generationCount);
+
+	// with ppo there is one policy, it learns from every game's decisions and its mean is the best network. the score
+	// reported is the mean over the games, which played it with its noise
+	if (m_proximalPolicy)
+	{
+		double score = 0;
+		for (unsigned i = 0; i < parrelelGames; ++i)
+			score += m_agents.score[m_agents.index(0, i)];
+
+		m_ppo.update(*m_threadPool);
+		m_bestNetwork = m_ppo.policy();
+		best_net_info.Network = &m_bestNetwork;
+		best_net_info.score = static_cast<float>(score / parrelelGames);
+
+		m_league.add(m_bestNetwork, m_generationCount, best_net_info.score);
+		setOpponent(m_league.opponent(m_generationCount));
+		return;
+	}
+
+	// with evolution strategies the search starts from the best network of the first (random) generation, after that
+	// the centre steps along the scores every game got. the score reported is the centre's own, game 0 played it
+	if (m_evolutionStrategies)
+	{
+		if (m_strategies.started())
+		{
+			std::vector<float> scores(parrelelGames);
+			for (unsigned i = 0; i < parrelelGames; ++i)
+				scores[i] = m_agents.score[m_agents.index(0, i)];
+
+			m_strategies.step(scores);
+			best_net_info.score = scores[0];
+		}
+		else
+			m_strategies.start(*best_net_info.Network);
+	}
+
+	// the best network lives inside one of the games that are about to be overwritten, so it is copied out first
+	m_bestNetwork = m_evolutionStrategies ? m_strategies.centre() : *best_net_info.Network;
+	const NeuralNetwork* bestNetwork = &m_bestNetwork;
+	m_league.add(*bestNetwork, m_generationCount, best_net_info.score);
 	
 
 	// finding the next neural network to use for the teacher agent to train the learning agent
-	const NeuralNetwork* newPastNetwork = selfRL.get_network(m_generationCount);
+	setOpponent(m_league.opponent(m_generationCount));
 
-	for (Game& game : m_allGames)
+	if (m_evolutionStrategies)
 	{
-		bestNetwork->mutate(&game.networks[0]);
-		newPastNetwork->mutate(&game.networks[1], 0.0, 0.0, 0.0, 0.0);
+		m_strategies.sample(parrelelGames);
+		m_threadPool->parallelFor(parrelelGames, gamesPerChunk, [&](const unsigned begin, const unsigned end, unsigned)
+		{
+			for (unsigned i = begin; i < end; ++i)
+			{
+				m_strategies.perturb(i, &m_allGames[i].learner);
+				syncInferenceWeights(i);
+			}
+		});
+		return;
 	}
 
-	// the first game will always be the best network of the last round
-	bestNetwork->mutate(&m_allGames[0].networks[0], 0.0, 0.0, 0.0, 0.0);
-	newPastNetwork->mutate(&m_allGames[0].networks[1], 0.0, 0.0, 0.0, 0.0);
+	// every game mutates from its own random stream, so the games can be split between the workers and
+	// the children of any generation can be reproduced from the run seed
+	m_threadPool->parallelFor(parrelelGames, gamesPerChunk, [&](const unsigned begin, const unsigned end, unsigned)
+	{
+		for (unsigned i = begin; i < end; ++i)
+		{
+			Game& game = m_allGames[i];
+			RandomDist::seed(RandomDist::Mutation, m_generationCount, i);
+
+			// the first game will always be the best network of the last round
+			if (i == 0)
+				bestNetwork->mutate(&game.learner, 0.0, 0.0, 0.0, 0.0);
+			else
+				bestNetwork->mutate(&game.learner);
+
+			syncInferenceWeights(i);
+		}
+	});
 }
 
 
-void Simulation::tickGames(bool& stop)
+// how game `game` went for its learner against an opponent that scored `opponentScore` when it was the learner itself
+// (League::Snapshot::score): 1 when the learner scored lower (lower is better), 0.5 on a tie, 0 otherwise. both played the learner's seat, which starts
+// out it and pays for every tag, against the other seats the learner would lose nearly every game whoever it played.
+// the learner's score is scaled to a full length game like the snapshot's is (a race's last round is shorter). a
+// snapshot that never was the learner (the random one the league starts with, saves from before scores were kept)
+// has no score, every game against it is a draw
+float Simulation::leagueResult(const unsigned game, const float opponentScore) const
 {
-	if (!m_paused)
+	if (opponentScore <= 0.f)
+		return 0.5f;
+
+	const float frames = static_cast<float>(std::max(m_allGames[game].frameLength, 1));
+	const float learner = m_agents.score[m_agents.index(0, game)] * static_cast<float>(GameSettings::gameFrameLength) / frames;
+	return learner < opponentScore ? 1.f : learner == opponentScore ? 0.5f : 0.f;
+}
+
+
+// every game of the generation that just ended was one match of the learner against the league's current opponent,
+// the games a race knocked out early sat out its last round
+void Simulation::recordLeagueResults()
+{
+	for (unsigned i = 0; i < parrelelGames; ++i)
 	{
-		for (Game& game : m_allGames)
-			stop = game.tick();
+		if (m_allGames[i].frameLength > 0)
+			m_league.record(leagueResult(i, m_league.currentOpponent().score));
 	}
 }
 
+
+void Simulation::tickGames(bool& stop)
+{
+	// every game is independent so they are split between the workers, parallelFor is the barrier
+	// which makes sure all games have finished the frame before anything reads them
+	const auto playing = [this] { return std::count_if(m_allGames.begin(), m_allGames.end(), [](const Game& game) { return game.playing(); }); };
+	const auto games = playing();
+
+	m_threadPool->parallelFor(parrelelGames, gamesPerChunk, [this](const unsigned begin, const unsigned end, unsigned)
+	{
+		tickGameRange(begin, end);
+	});
+
+	m_genSteps += games;
+	stop = playing() == 0;
+}
+
+
+void Simulation::printGenerationStats()
+{
+	const auto now = std::chrono::steady_clock::now();
+	const double seconds = std::chrono::duration<double>(now - m_genStart).count();
+	const auto stepsPerSecond = static_cast<unsigned long long>(seconds > 0 ? m_genSteps / seconds : 0);
+
+	std::cout << "[stats]: gen " << m_generationCount << ", best score " << best_net_info.score
+		<< ", " << stepsPerSecond << " game steps/s (" << m_threadPool->size() << " threads)"
+		<< ", run time " << static_cast<unsigned>(m_totalRunTime) << "s";
+	if (m_earlyTermination)
+		std::cout << ", " << 100.0 * m_genSkipped / std::max(m_genSteps + m_genSkipped, 1ull) << "% of frames skipped";
+	std::cout << ", league of " << m_league.size() << " (learner elo " << static_cast<int>(m_league.learnerRating())
+		<< ", opponent " << static_cast<int>(m_league.currentOpponent().rating) << ")\n";
+
+	m_genSteps = 0;
+	m_genSkipped = 0;
+	m_genStart = now;
+}
+
+
+unsigned Simulation::threadsToUse()
+{
+	return (threadCount == 0) ? WorkStealingPool::hardwareThreads() : threadCount;
+}
+
 void Simulation::endOfGenStats()
 {
 	++m_generationCount;
+	m_totalRunTime += GetDelta();
+	if (!racesGenerations() && !steadyRunning())
+		m_genSkipped += framesSkipped(); // a race and the steady state count their own as the games finish
+
+	if (m_generationCount % statsFreq == 0)
+		printGenerationStats();
 
 	if (m_generationCount == 1000)
 	{
@@ -103,63 +590,96 @@ void Simulation::endOfGenStats()
 		//m_closeSim = true;
 	}
 
-	if (m_auto_save && m_generationCount % autoSaveFreq == 0)
+	const bool finished = reachedRunLimits();
+	if (m_auto_save && (m_generationCount % autoSaveFreq == 0 || finished))
 	{
 		saveNetworkData();
 	}
+
+	if (finished)
+	{
+		std::cout << "[notice]: run limit reached at gen " << m_generationCount << "\n";
+		m_closeSim = true;
+	}
+}
+
+
+bool Simulation::reachedRunLimits() const
+{
+	if (m_maxGenerations != 0 && m_generationCount >= m_maxGenerations)
+		return true;
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_runStart).count();
+	return m_maxRunSeconds > 0 && seconds >= m_maxRunSeconds;
 }
 
-void Simulation::resetGames()
+
+void Simulation::setRunLimits(const unsigned maxGenerations, const double maxRunSeconds)
 {
-	// getting the starting positions
+	m_maxGenerations = maxGenerations;
+	m_maxRunSeconds = maxRunSeconds;
+	m_runStart = std::chrono::steady_clock::now();
+}
+
+// `episode` counts the episodes of this generation (more than one in a race), each one starts from fresh positions
+void Simulation::resetGames(const unsigned episode, const unsigned frames)
+{
+	// getting the starting positions, every game starts from the same ones
+	RandomDist::seed(RandomDist::Positions, m_generationCount, episode);
 	const std::vector<sf::Vector2f> positions = rearrangePositions(bounds, GameSettings::agentsPergame);
-	
 
-	for (Game& game : m_allGames)
+	m_threadPool->parallelFor(parrelelGames, gamesPerChunk, [&](const unsigned begin, const unsigned end, unsigned)
 	{
-		game.initiliseGame(positions);
-	}
+		for (unsigned i = begin; i < end; ++i)
+		{
+			RandomDist::seed(RandomDist::Reset, m_generationCount, static_cast<uint64_t>(episode) * parrelelGames + i);
+			m_allGames[i].initiliseGame(positions, frames);
+		}
+	});
 
-	if (best_net_info.learnerPosition != sf::Vector2f{ 0.f, 0.f })
+	// a race compares every candidate from the same start, so there game 0 does not replay the last best one's
+	if (!racesGenerations() && best_net_info.learnerPosition != sf::Vector2f{ 0.f, 0.f })
 	{
-		m_allGames[0].agents[0].position = best_net_info.learnerPosition;
-		m_allGames[0].agents[1].position = best_net_info.trainerPosition;
+		m_agents.setPosition(0, 0, best_net_info.learnerPosition);
+		m_agents.setPosition(1, 0, best_net_info.trainerPosition);
 	}
 
-	for (Game& game : m_allGames) {for (Agent& agent : game.agents) {
-		agent.gameStartPos = agent.position;
-	}}
+	m_agents.markStartPositions();
 }
 
 
 void Simulation::getTopNet()
 {
-	// sorting to get the best two networks
-	best_net_info.score = 100000;
-	best_net_info.Network = nullptr;
+	const unsigned best = bestLearner();
+
+	// a race's score is scaled to one full length game so the stats line reads the same either way
+	best_net_info.score = raced()
+		? m_raceScores[best] * static_cast<float>(GameSettings::gameFrameLength) / static_cast<float>(m_raceFrames)
+		: m_agents.score[m_agents.index(0, best)];
+	best_net_info.Network = &m_allGames[best].learner;
+	best_net_info.learnerPosition = m_agents.startPosition(0, best);
+	best_net_info.trainerPosition = m_agents.startPosition(1, best);
+}
 
-	for (unsigned i = 0; i < parrelelGames; i++)
-	{
-		Game& game = m_allGames[i];
-		const float score = game.agents[0].network_score;
 
-		if (score < best_net_info.score)
+// the game whose learner scored lowest, the first one of a tie. after a race, the survivor with the lowest score over
+// all of its rounds. before any race has run (a run resumed with --race) it is the first of these too
+unsigned Simulation::bestLearner() const
+{
+	if (raced())
+	{
+		return *std::min_element(m_racers.begin(), m_racers.end(), [this](const unsigned a, const unsigned b)
 		{
-			best_net_info.score = score;
-			best_net_info.Network = &game.networks[0];
-			best_net_info.learnerPosition = game.agents[0].gameStartPos;
-			best_net_info.trainerPosition = game.agents[1].gameStartPos;
-
-		}
+			return m_raceScores[a] < m_raceScores[b];
+		});
 	}
-	if (m_generationCount % 10 == 0)
-		std::cout << "best score for gen " << m_generationCount << ": " << best_net_info.score << "\n";
 
+	unsigned best = 0;
+	for (unsigned i = 1; i < parrelelGames; i++)
+	{
+		if (m_agents.score[m_agents.index(0, i)] < m_agents.score[m_agents.index(0, best)])
+			best = i;
+	}
+	return best;
 }
 
-void Simulation::endFrame()
-{
-	// updating runtime statistics and ending the frame
-	m_totalFrameCount++;
-	m_totalRunTime += GetDelta();
-}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "simulation.hpp"
+
+
+// a generation of proximal policy optimisation: every game starts from its own positions and its learner plays the
+// one policy, sampling its steering from the policy's gaussian, while ProximalPolicyOptimisation records every
+// decision. prepareNextAgents() then learns from all of them. the policy starts from the best network so far, so
+// --ppo can pick up a population that has already been evolving
+void Simulation::runRollout()
+{
+	if (!m_ppo.started())
+		m_ppo.start(m_bestNetwork, parrelelGames);
+	m_ppo.beginRollout();
+
+	m_threadPool->parallelFor(parrelelGames, gamesPerChunk, [&](const unsigned begin, const unsigned end, unsigned)
+	{
+		for (unsigned i = begin; i < end; ++i)
+		{
+			RandomDist::seed(RandomDist::Policy, m_generationCount, i);
+			m_allGames[i].learner = m_ppo.policy();
+			m_allGames[i].initiliseGame(rearrangePositions(bounds, GameSettings::agentsPergame));
+		}
+	});
+	m_agents.markStartPositions();
+
+	while (m_paused && !m_closeSim)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	m_threadPool->parallelFor(parrelelGames, 1, [this](const unsigned begin, const unsigned end, unsigned)
+	{
+		for (unsigned i = begin; i < end; ++i)
+			playRollout(i);
+	});
+
+	m_genSteps += framesPlayed();
+	m_totalFrameCount += GameSettings::gameFrameLength;
+}
+
+
+// plays game `game` to the end. the learner's steering comes from the policy on every deciding frame and is held in
+// between like the networks' outputs are, the opponents play exactly like in Game::tick(). whatever the learner's
+// score did over a frame is that frame's reward, added to its last decision. where the learner is left when the time
+// runs out is kept to bootstrap the last decision's value from
+void Simulation::playRollout(const unsigned game)
+{
+	constexpr unsigned actions = ProximalPolicyOptimisation::actions;
+
+	Game& played = m_allGames[game];
+	CounterRng rng{ CounterRng::streamKey(RandomDist::runSeed.load(), RandomDist::Policy, m_generationCount, parrelelGames + game), 0 };
+	float observation[ProximalPolicyOptimisation::observations];
+	float action[actions] = {};
+	const unsigned learner = m_agents.index(0, game);
+
+	bool over = false;
+	while (!over)
+	{
+		const float before = m_agents.score[learner];
+		const bool decide = played.decides();
+		if (decide)
+		{
+			m_agents.setNetworkInputs(0, game, observation);
+			m_ppo.decide(game, observation, action, rng);
+		}
+
+		if (m_simultaneousTicks)
+		{
+			for (unsigned slot = 1; slot < GameSettings::agentsPergame && decide; ++slot)
+			{
+				m_agents.setNetworkInputs(slot, game, played.activations[slot].inputs.data());
+				played.opponent->compute_output(played.activations[slot]);
+			}
+
+			m_agents.integrate(0, game, game + 1, action, 0);
+			for (unsigned slot = 1; slot < GameSettings::agentsPergame; ++slot)
+				m_agents.integrate(slot, game, game + 1, played.activations[slot].outputs.data(), 0);
+			m_agents.resolve(game, game + 1);
+		}
+		else
+		{
+			m_agents.act(0, game, game + 1, action, 0);
+			for (unsigned slot = 1; slot < GameSettings::agentsPergame; ++slot)
+			{
+				if (decide)
+				{
+					m_agents.setNetworkInputs(slot, game, played.activations[slot].inputs.data());
+					played.opponent->compute_output(played.activations[slot]);
+				}
+				m_agents.act(slot, game, game + 1, played.activations[slot].outputs.data(), 0);
+			}
+		}
+
+		over = played.countDown();
+		m_ppo.reward(game, before - m_agents.score[learner]);
+
+		if (game == 0)
+			publishSnapshot();
+	}
+
+	m_agents.setNetworkInputs(0, game, observation);
+	m_ppo.finish(game, observation);
+}
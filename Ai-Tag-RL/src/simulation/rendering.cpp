@@ -1,9 +1,30 @@
-#include "Simulation.hpp"
+#include "simulation.hpp"
 
 #include <SFML/Graphics.hpp>
+#include <thread>
 #include "../utility.hpp"
 
 
+// the window thread: draws whatever snapshot of game 0 the training thread published last
+void Simulation::uihandeling()
+{
+	GameSnapshot snapshot{};
+
+	while (!m_closeSim)
+	{
+		pollEvents();
+
+		const bool hasSnapshot = m_gameSnapshots.read(snapshot);
+		setWindowTitle(snapshot);
+
+		if (m_rendering && hasSnapshot)
+			renderFrame(snapshot);
+		else
+			std::this_thread::sleep_for(std::chrono::milliseconds(1000 / snapshotRate));
+	}
+}
+
+
 void Simulation::keyPressEvents(const sf::Keyboard::Key& event_key_code)
 {
 	const bool ctrl = sf::Keyboard::isKeyPressed(sf::Keyboard::LControl);
@@ -23,10 +44,6 @@ void Simulation::keyPressEvents(const sf::Keyboard::Key& event_key_code)
 		m_debug = not m_debug;
 		break;
 
-	case sf::Keyboard::Key::U:
-		m_allrender = not m_allrender;
-		break;
-
 	case sf::Keyboard::Key::A:
 		m_auto_save = not m_auto_save;
 		std::cout << "[Setting]: Autosave: " << m_auto_save << "\n";
@@ -36,28 +53,19 @@ void Simulation::keyPressEvents(const sf::Keyboard::Key& event_key_code)
 		m_debugValue = not m_debugValue;
 		break;
 
-	case sf::Keyboard::Key::F:
-		fastForward = true;
-		break;
-
 	case sf::Keyboard::Key::S:
 		if (ctrl)
-			saveNetworkData();
+			m_saveRequested = true;
 		break;
 
 	case sf::Keyboard::Key::L:
 		if (ctrl)
-			loadNetworkData();
+			m_loadRequested = true;
 		break;
 
 
 	case sf::Keyboard::Key::R:
 		m_rendering = not m_rendering;
-
-		if (m_rendering == true)
-			m_window.setFramerateLimit(100);
-		else
-			m_window.setFramerateLimit(999'999);
 		break;
 
 	default:
@@ -87,11 +95,11 @@ sf::Color Simulation::getColor(const bool tagged)
 }
 
 
-void Simulation::renderAgents()
+void Simulation::renderAgents(const GameSnapshot& snapshot)
 {
 	for (unsigned i = 0; i < GameSettings::agentsPergame; i++)
 	{
-		Agent& agent = m_allGames[0].agents[i];
+		const AgentSnapshot& agent = snapshot.agents[i];
 		m_agentRenderCircle.setPosition(agent.position - sf::Vector2f{AgentSettings::radius, AgentSettings::radius});
 		m_agentRenderCircle.setFillColor(getColor(agent.tagged));
 		m_agentRenderCircle.setOutlineColor(colors[i]);
@@ -100,7 +108,7 @@ void Simulation::renderAgents()
 }
 
 
-void Simulation::renderFrame()
+void Simulation::renderFrame(const GameSnapshot& snapshot)
 {
 	// Clearing the screen
 	m_window.clear(windowColor);
@@ -109,20 +117,20 @@ void Simulation::renderFrame()
 	m_window.draw(m_gameBorderRenderer);
 
 	// Rendering Agents
-	renderAgents();
+	renderAgents(snapshot);
 	//m_agentRenderCircle.setFillColor(AgentSettings::itColor);
 	//m_agentRenderCircle.setPosition(posToFollow::position - sf::Vector2f{AgentSettings::radius, AgentSettings::radius});
 	//m_window.draw(m_agentRenderCircle);
 
 	if (m_debug)
-		debugAgents();
+		debugAgents(snapshot);
 
 
 	m_window.display();
 }
 
 
-void Simulation::setWindowTitle()
+void Simulation::setWindowTitle(const GameSnapshot& snapshot)
 {
 	const sf::Int32 msPerFrame = m_clock.restart().asMilliseconds();
 	if (msPerFrame != 0)
@@ -131,41 +139,33 @@ void Simulation::setWindowTitle()
 		m_frameRateManager.updateFrameRates(fps);
 
 		std::ostringstream oss;
-		oss << simulationName << " " << fps << "fps, gen " << m_generationCount << ", time until next gen: " << m_allGames[0].timeRemaining  << " \n";
+		oss << simulationName << " " << fps << "fps, gen " << snapshot.generation << ", time until next gen: " << snapshot.timeRemaining  << " \n";
 		const std::string stringFrameRate = oss.str();
 		m_window.setTitle(stringFrameRate);
 	}
 }
 
 
-void Simulation::debugAgents()
+void Simulation::debugAgents(const GameSnapshot& snapshot)
 {
-	for (Game& game : m_allGames)
+	for (const AgentSnapshot& agent : snapshot.agents)
 	{
-		for (Agent& agent : game.agents)
-		{
-			debugAgent(&agent);
-		}
-
-		if (!m_allrender)
-			break;
+		debugAgent(agent);
 	}
 }
 
 
-void Simulation::debugAgent(const Agent* agent)
+void Simulation::debugAgent(const AgentSnapshot& agent)
 {
-	const sf::Vector2f position = agent->position;
+	const sf::Vector2f position = agent.position;
 
 	// Normalize the velocity vector
-	const sf::Vector2f velocity = agent->m_velocity * 5.f;
-	const sf::Vector2f accelaration = agent->m_accelaration * 1000.f;
+	const sf::Vector2f velocity = agent.velocity * 5.f;
 
 	m_window.draw(makeLine(position, position + velocity, { 255, 0  , 0 }));
-	m_window.draw(makeLine(position + velocity, position + velocity + accelaration, { 0, 255  , 0 }));
 
 
 	sf::RenderStates states{};
-	const auto value = static_cast<int>(roundToNearestN(agent->network_score, 1));
-	scores.drawCenteredValue(agent->position, value, states);
+	const auto value = static_cast<int>(roundToNearestN(agent.score, 1));
+	scores.drawCenteredValue(agent.position, value, states);
 }
\ No newline at end of file
@@ -8,6 +8,16 @@
 #include "../utility.hpp"
 #include "../Agent.hpp"
 #include "../game.hpp"
+#include "../thread_pool.hpp"
+#include "../snapshot_buffer.hpp"
+#include "../BatchedInference.hpp"
+#include "../mpsc_queue.hpp"
+#include "../evolution_strategies.hpp"
+#include "../ppo.hpp"
+#include "../league.hpp"
+#include "../mapped_file.hpp"
+#include "../checkpoint.hpp"
+#include "../checkpoint_writer.hpp"
 
 
 struct BestNetworkInfo
@@ -19,73 +29,205 @@ struct BestNetworkInfo
 };
 
 
+// one of the networks the steady state evolution breeds from, ranked by the mean score of the games it played
+struct EliteNetwork
+{
+	float score;
+	unsigned evaluations;
+	uint64_t id; // its birth number, a replay result finds its network by it
+	NeuralNetwork network;
+};
+
+
 
 class Simulation : Settings, DeltaTime
 {
+#ifndef HEADLESS
 	// ---------- SFML window ---------- //
 	sf::Clock m_clock{};
 	sf::RenderWindow m_window{ sf::VideoMode(
 		static_cast<unsigned>(windowSize.x), static_cast<unsigned>(windowSize.y)), simulationName };
+#endif
 
 	// ---------- containers ---------- //
+	AgentStore m_agents{};        // the agents of every game, see Agent.hpp
 	std::vector<Game> m_allGames; // run in parrelel (multi-threading)
+	std::unique_ptr<WorkStealingPool> m_threadPool;
+	BatchedInference m_inference[GameSettings::agentsPergame]; // one batch per agent slot, a row per game, slot 0 learns
 
 	// ---------- other ---------- //
+#ifndef HEADLESS
 	BetterFrameRates<60> m_frameRateManager;
-	ReinforcementLearning selfRL{};
+#endif
+	League m_league{};
+	CheckpointWriter m_checkpointWriter{}; // saves are copied out here and written on its thread
+	uint64_t m_checkpointId = 0;           // the full checkpoint the next delta goes on top of, 0 until one is written
+	uint32_t m_deltaSequence = 0;
+	uint64_t m_checkpointSize = 0;         // bytes in that checkpoint and in the deltas after it
+	uint64_t m_deltaLogSize = 0;
+	EvolutionStrategies m_strategies{};
+	ProximalPolicyOptimisation m_ppo{};
 	BestNetworkInfo best_net_info{};
 
+	// ---------- render snapshots ---------- //
+	SnapshotBuffer<GameSnapshot> m_gameSnapshots{}; // game 0, written by the training thread, read by the window thread
+	std::chrono::steady_clock::time_point m_lastSnapshot{};
+
 	// ---------- statistics ---------- //
-	bool m_closeSim  = false;
-	bool m_paused    = false;
+	// the first group is shared between the window thread and the training thread
+	std::atomic<bool> m_closeSim  = false;
+	std::atomic<bool> m_paused    = false;
+	std::atomic<bool> m_rendering = true;
+	std::atomic<bool> m_auto_save = false;
+	std::atomic<bool> m_saveRequested = false;
+	std::atomic<bool> m_loadRequested = false;
+
 	bool m_debug     = true;
-	bool m_rendering = true;
 	bool m_debugValue= false;
-	bool m_allrender = false;
-	bool m_auto_save = false;
-	bool fastForward = false;
+	bool m_fusedEpisodes = fusedEpisodes;
+	bool m_batchedInference = batchedInference;
+	bool m_simultaneousTicks = simultaneousTicks;
+	unsigned m_decisionInterval = decisionInterval;
+	bool m_staggerDecisions = staggerDecisions;
+	bool m_earlyTermination = GameSettings::earlyTermination;
+	bool m_racing = racing;
+	bool m_steadyState = steadyState;
+	bool m_evolutionStrategies = evolutionStrategies;
+	bool m_proximalPolicy = proximalPolicy;
 
 	unsigned m_totalFrameCount = 0;
-	unsigned m_generationCount = 1;
+	std::atomic<unsigned> m_generationCount = 1; // the steady state's workers read it for the snapshots while it changes
 	double m_totalRunTime      = 0;
 
+	unsigned long long m_genSteps = 0;   // game ticks since the last steps per second report
+	unsigned long long m_genSkipped = 0; // game ticks early termination skipped since then
+	std::chrono::steady_clock::time_point m_genStart = std::chrono::steady_clock::now();
+
+	// ---------- racing ---------- //
+	std::vector<unsigned> m_racers{}; // the games whose candidates are still in this generation's race
+	std::vector<float> m_raceScores{}; // every candidate's score summed over the rounds it played
+	unsigned m_raceFrames = 0;        // frames each survivor has played so far
+
+	// ---------- steady state evolution ---------- //
+	struct SteadyRun; // the state of one runSteadyState(), see steady_state.cpp
+	std::vector<EliteNetwork> m_elite{}; // best first
+	uint64_t m_births = 0;
+
+	// ---------- run limits ---------- //
+	unsigned m_maxGenerations = 0; // stop once this generation is reached, 0 = never
+	double m_maxRunSeconds    = 0; // stop once this process has trained for this long, 0 = never
+	std::chrono::steady_clock::time_point m_runStart = std::chrono::steady_clock::now();
+	std::string m_saveFile = "network_data.ckpt";
+
+#ifndef HEADLESS
 	// ---------- debugging ---------- //
 	sf::CircleShape m_agentRenderCircle{};
 	sf::CircleShape m_gameBorderRenderer{};
 
 	FontManager scores;
+#endif
 
 
 	NeuralNetwork trainerAgentNet{};
+	NeuralNetwork m_bestNetwork{};
 
 
 public:
-	explicit Simulation();
+	explicit Simulation(unsigned threads = threadsToUse());
 	static void printNetworkInfo();
-	static void runGame(Game* game);
+	static void runGame(Game* game, bool simultaneous);
 	void run();
+	void noticeOverriddenModes() const;
+	void trainingLoop();
+	void runGeneration();
+	void runRace();
+	void runSteadyState();
+	void steadyPlay(SteadyRun& run, bool evolving);
+	void steadyCollect(SteadyRun& run);
+	void steadyBreed(SteadyRun& run, unsigned unit);
+	void steadyGeneration(SteadyRun& run);
+	void steadyRelease(SteadyRun& run, unsigned unit);
+	void runRollout();
+	void playRollout(unsigned game);
+	unsigned episodeChunk() const;
+	void playEpisodes(unsigned begin, unsigned end);
+	void runGenerationLockstep();
+	void runGenerationFused();
+	void runWatchedGame();
+	void setFusedEpisodes(bool fused) { m_fusedEpisodes = fused; }
+	void setBatchedInference(bool batched) { m_batchedInference = batched; }
+	void setSimultaneousTicks(bool simultaneous) { m_simultaneousTicks = simultaneous; }
+	void setDecisionInterval(unsigned interval, bool staggered);
+	void setEarlyTermination(bool enabled);
+	void setRacing(bool enabled) { m_racing = enabled; }
+	void setSteadyState(bool enabled) { m_steadyState = enabled; }
+	void setEvolutionStrategies(bool enabled) { m_evolutionStrategies = enabled; }
+	void setProximalPolicy(bool enabled) { m_proximalPolicy = enabled; }
+	bool racesGenerations() const { return m_racing && !m_evolutionStrategies && !m_proximalPolicy; } // the generations are races (runRace)
+	bool raced() const { return racesGenerations() && !m_racers.empty() && m_raceFrames != 0; } // a race has finished since the last reset
+	bool steadyRunning() const { return m_steadyState && !m_proximalPolicy; } // the training runs runSteadyState()
+	unsigned long long framesSkipped() const;
+	unsigned long long framesPlayed() const;
+	void tickGameRange(unsigned begin, unsigned end);
+	void tickBatchedRange(unsigned begin, unsigned end);
+	void syncInferenceWeights(unsigned game);
+	void setOpponent(const NeuralNetwork* opponent);
+	void processUiRequests();
+	void publishSnapshot();
 	void prepareNextAgents();
-	void uihandeling();
+	float leagueResult(unsigned game, float opponentScore) const;
+	void recordLeagueResults();
 	void tickGames(bool& stop);
+	void printGenerationStats();
+	void benchmarkThreadCounts();
+	void benchmarkSteppingModes();
+	static bool benchmarkForwardPass();
+	static bool benchmarkPhysics();
+	static bool benchmarkArchive(unsigned snapshots);
+	static void benchmarkDecisionIntervals(unsigned threads, unsigned generations, bool staggered);
+	void benchmarkEarlyTermination(unsigned generations);
+	static void benchmarkRacing(unsigned threads, unsigned generations);
+	static void benchmarkSteadyState(unsigned threads, unsigned generations, bool earlyTermination);
+	static void benchmarkEvolutionStrategies(unsigned threads, unsigned generations);
+	static void benchmarkProximalPolicy(unsigned threads, double seconds, float targetScore);
+	static void benchmarkLeague(unsigned threads, unsigned generations);
+	float heldOutScore(const NeuralNetwork& network, const NeuralNetwork& opponent, float* winRate = nullptr, float opponentScore = 0);
+	static unsigned threadsToUse();
+	static int fromArguments(int argc, char* argv[]);
 	void endOfGenStats();
-	void resetGames();
+	bool reachedRunLimits() const;
+	void setRunLimits(unsigned maxGenerations, double maxRunSeconds);
+	void setAutoSave(bool autoSave) { m_auto_save = autoSave; }
+	void setSaveFile(const std::string& saveFile) { m_saveFile = saveFile; m_checkpointId = 0; }
+	void resetGames(unsigned episode = 0, unsigned frames = GameSettings::gameFrameLength);
 	void getTopNet();
+	unsigned bestLearner() const;
 
-	void endFrame();
 	void initGames();
+	std::string freshArchivePath() const;
+	std::string deltaLogPath() const;
+	bool archiveLeague();
+	std::vector<char> checkpointBytes();
+	std::vector<char> checkpointDelta();
 	void saveNetworkData();
-	void loadNetworkData();
+	bool loadNetworkData();
+	bool importNetworkData();
+	void exportNetworkData(const std::string& file);
+	void resumeFrom(const NeuralNetwork* best);
 
+#ifndef HEADLESS
+	void uihandeling();
 	void pollEvents();
 	void keyPressEvents(const sf::Keyboard::Key& event_key_code);
 	static sf::Color getColor(bool tagged);
-	void renderAgents();
-	void debugAgents();
+	void renderAgents(const GameSnapshot& snapshot);
+	void debugAgents(const GameSnapshot& snapshot);
 
 	// ---------- graphics ---------- //
-	void renderFrame();
-	void setWindowTitle();
-	void debugAgent(const Agent* agent);
+	void renderFrame(const GameSnapshot& snapshot);
+	void setWindowTitle(const GameSnapshot& snapshot);
+	void debugAgent(const AgentSnapshot& agent);
 	void initDebugGraphics();
+#endif
 
 };
\ No newline at end of file
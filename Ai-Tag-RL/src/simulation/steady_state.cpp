@@ -0,0 +1,245 @@
+#include "simulation.hpp"
+
+
+// steady state evolution: there is no generation barrier. the games are handed out in units (episodeChunk() games
+// played side by side), a worker plays a unit's episodes to the end and pushes every game's (game, score) to a
+// lock-free queue. the evolution thread (the one that called runSteadyState, it plays units too when nothing is
+// waiting) ranks each finished network into the elite, breeds that game's next learner from the elite straight away
+// and hands the unit back out once all of its games have one, so no worker waits for the slowest game of a
+// generation. a "generation" is just every parrelelGames results, the stats, autosaves and run limits still tick on it.
+// the only waits left are for the things every game has to see at once: a new opponent or a new network in the
+// league. the units are then held back until none is out, at every snapshot and at every League::swap_steps
+// generations whose draw picked an opponent other than the one being played
+struct Simulation::SteadyRun
+{
+	enum State : uint8_t { Ready, Playing, Finished };
+
+	struct Result
+	{
+		unsigned game;
+		float score;
+	};
+
+	SteadyRun(const unsigned games, const unsigned unitSize)
+		: size(unitSize), units((games + unitSize - 1) / unitSize), states(units), results(games),
+		  received(units, 0), id(games, 0), parent(games, 0), replay(games, false) {}
+
+	unsigned size;  // games per unit
+	unsigned units;
+	std::vector<std::atomic<uint8_t>> states; // Ready: waiting for a worker, Playing: taken, Finished: results sent
+	MpscQueue<Result> results;                // a game has at most one result waiting, so it never fills up
+	std::atomic<bool> finished = false;       // the workers stop looking for units
+
+	// only the evolution thread touches the rest
+	std::vector<unsigned> received; // results in from each unit's current episodes
+	std::vector<uint64_t> id;       // birth number of every game's learner
+	std::vector<uint64_t> parent;   // the elite network a replay game plays
+	std::vector<bool> replay;       // the game plays an elite network unmutated, its score joins that network's mean
+	unsigned inFlight = 0;          // units handed out whose results are not all in
+	unsigned generationResults = 0; // results since the last generation
+	bool draining = false;          // holding bred units back until none are out
+	bool stopping = false;          // draining to return, nothing is bred any more
+	unsigned changeGeneration = 0;  // the generation whose pool and opponent change waits for the drain
+	std::vector<unsigned> held{};   // units bred while draining
+};
+
+
+void Simulation::runSteadyState()
+{
+	SteadyRun run{ parrelelGames, episodeChunk() };
+
+	// every worker starts from the learners prepareNextAgents() (or the constructor) left, from one shared start
+	m_elite.clear();
+	RandomDist::seed(RandomDist::Evolution, m_generationCount, 1);
+	resetGames();
+	for (unsigned i = 0; i < parrelelGames; ++i)
+		run.id[i] = m_births++;
+	run.inFlight = run.units;
+
+	// one long running task per worker, the calling thread takes the first and with it the evolution
+	m_threadPool->parallelFor(m_threadPool->size(), 1, [&](const unsigned begin, unsigned, unsigned)
+	{
+		steadyPlay(run, begin == 0);
+	});
+}
+
+
+// a worker's loop: take the next unit that is ready, play it and send its results. the evolution thread collects the
+// results in between units. every worker looks on from the unit after the last one it played, a unit that is handed
+// straight back out would otherwise be played over and over while the others wait
+void Simulation::steadyPlay(SteadyRun& run, const bool evolving)
+{
+	unsigned next = 0;
+	while (!run.finished.load(std::memory_order_acquire))
+	{
+		if (evolving)
+			steadyCollect(run);
+
+		if (m_paused)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			continue;
+		}
+
+		bool played = false;
+		for (unsigned tried = 0; tried < run.units && !played; ++tried)
+		{
+			const unsigned unit = (next + tried) % run.units;
+			uint8_t ready = SteadyRun::Ready;
+			if (!run.states[unit].compare_exchange_strong(ready, SteadyRun::Playing, std::memory_order_acquire))
+				continue;
+
+			const unsigned begin = unit * run.size;
+			const unsigned end = std::min(begin + run.size, parrelelGames);
+			playEpisodes(begin, end);
+
+			run.states[unit].store(SteadyRun::Finished, std::memory_order_relaxed);
+			for (unsigned i = begin; i < end; ++i)
+			{
+				while (!run.results.push({ i, m_agents.score[m_agents.index(0, i)] }))
+					std::this_thread::yield();
+			}
+			next = unit + 1;
+			played = true;
+		}
+
+		if (!played)
+			std::this_thread::yield();
+	}
+}
+
+
+// the evolution thread: ranks every result that came in, breeds the units whose games are all back and does the
+// generation's bookkeeping
+void Simulation::steadyCollect(SteadyRun& run)
+{
+	if (!run.stopping && (m_closeSim || m_loadRequested))
+		run.stopping = run.draining = true;
+
+	SteadyRun::Result result{};
+	while (run.results.pop(result))
+	{
+		const Game& game = m_allGames[result.game];
+		m_genSteps += game.framesPlayed();
+		m_genSkipped += game.framesSkipped;
+		m_league.record(leagueResult(result.game, m_league.currentOpponent().score));
+
+		if (run.replay[result.game])
+		{
+			// a lucky first game does not keep a network on top for good, every replay moves it to its mean
+			const auto entry = std::find_if(m_elite.begin(), m_elite.end(), [&](const EliteNetwork& elite) { return elite.id == run.parent[result.game]; });
+			if (entry != m_elite.end())
+			{
+				entry->score += (result.score - entry->score) / static_cast<float>(++entry->evaluations);
+				std::stable_sort(m_elite.begin(), m_elite.end(), [](const EliteNetwork& a, const EliteNetwork& b) { return a.score < b.score; });
+			}
+		}
+		else
+		{
+			const auto place = std::upper_bound(m_elite.begin(), m_elite.end(), result.score, [](const float score, const EliteNetwork& elite) { return score < elite.score; });
+			if (m_elite.size() < eliteSize || place != m_elite.end())
+			{
+				m_elite.insert(place, { result.score, 1, run.id[result.game], game.learner });
+				if (m_elite.size() > eliteSize)
+					m_elite.pop_back();
+			}
+		}
+
+		const unsigned unit = result.game / run.size;
+		if (++run.received[unit] == std::min(run.size, parrelelGames - unit * run.size))
+		{
+			run.received[unit] = 0;
+			--run.inFlight;
+			if (!run.stopping)
+				steadyBreed(run, unit);
+		}
+
+		if (!run.stopping && ++run.generationResults == parrelelGames)
+		{
+			run.generationResults = 0;
+			steadyGeneration(run);
+		}
+	}
+
+	if (!run.draining || run.inFlight != 0)
+		return;
+
+	if (run.stopping)
+	{
+		run.finished.store(true, std::memory_order_release);
+		return;
+	}
+
+	// no game is being played, the pool and the opponent can change under them
+	m_league.add(m_bestNetwork, run.changeGeneration, best_net_info.score);
+	setOpponent(m_league.opponent(run.changeGeneration));
+
+	run.draining = false;
+	for (const unsigned unit : run.held)
+		steadyRelease(run, unit);
+	run.held.clear();
+}
+
+
+// gives every game of `unit` a new learner and a fresh start. the first game of every chunk replays the best elite
+// network unmutated, like game 0 does for the generations, the others get a child of the winner of a two network
+// tournament over the elite
+void Simulation::steadyBreed(SteadyRun& run, const unsigned unit)
+{
+	const unsigned begin = unit * run.size;
+	const unsigned end = std::min(begin + run.size, parrelelGames);
+	const std::vector<sf::Vector2f> positions = rearrangePositions(bounds, GameSettings::agentsPergame);
+
+	for (unsigned i = begin; i < end; ++i)
+	{
+		Game& game = m_allGames[i];
+		run.replay[i] = i % gamesPerChunk == 0;
+
+		const unsigned last = static_cast<unsigned>(m_elite.size()) - 1;
+		const EliteNetwork& parent = run.replay[i] ? m_elite.front() : m_elite[std::min(RandomDist::randRange(0u, last), RandomDist::randRange(0u, last))];
+		if (run.replay[i])
+			game.learner = parent.network;
+		else
+			parent.network.mutate(&game.learner);
+
+		run.parent[i] = parent.id;
+		run.id[i] = m_births++;
+		syncInferenceWeights(i);
+
+		game.initiliseGame(positions);
+		m_agents.markStartPositions(i);
+	}
+
+	if (run.draining)
+		run.held.push_back(unit);
+	else
+		steadyRelease(run, unit);
+}
+
+
+void Simulation::steadyRelease(SteadyRun& run, const unsigned unit)
+{
+	++run.inFlight;
+	run.states[unit].store(SteadyRun::Ready, std::memory_order_release);
+}
+
+
+// what prepareNextAgents() and endOfGenStats() do between generations. a new network in the league or a new
+// opponent waits for the drain, a swap generation that picks the opponent already being played does not drain
+void Simulation::steadyGeneration(SteadyRun& run)
+{
+	m_bestNetwork = m_elite.front().network;
+	best_net_info.score = m_elite.front().score;
+	best_net_info.Network = &m_bestNetwork;
+
+	if (!run.draining && (m_generationCount % m_league.snapshotFrequency() == 0 || m_league.opponentChanges(m_generationCount)))
+	{
+		run.draining = true;
+		run.changeGeneration = m_generationCount;
+	}
+
+	if (m_saveRequested.exchange(false))
+		saveNetworkData();
+
+	endOfGenStats();
+}
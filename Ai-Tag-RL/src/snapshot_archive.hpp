@@ -0,0 +1,181 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "NeuralNetwork.hpp"
+#include "mapped_file.hpp"
+
+
+// every network that ever joined the league, in one append-only file of fixed-stride records that is memory-mapped
+// instead of read. a record is the generation the network joined at, its score and its raw parameter block, so
+// network i always sits at the same offset and nothing is parsed to start: opening the archive only maps the file and
+// a snapshot's pages are read from disk the first time it is picked. the file grows by doubling and is mapped again
+// when it does, `count` in the header says how many records are real. until open() is called (and for runs that never
+// save, like the benchmarks) the records are kept in memory
+class SnapshotArchive
+{
+public:
+	static constexpr uint32_t version = 1;
+	static constexpr char file_magic[8] = { 'A', 'I', 'T', 'A', 'G', 'S', 'N', 'P' };
+
+	struct alignas(64) Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t parameters; // NeuralNetwork::parameterCount, padding included
+		uint32_t stride;     // sizeof(Record)
+		uint32_t reserved;
+		uint64_t count;
+	};
+
+	struct alignas(64) Record
+	{
+		uint32_t generation;
+		float score;
+		std::array<float, NeuralNetwork::parameterCount> parameters;
+	};
+
+	static_assert(std::is_trivially_copyable_v<Header> && std::is_trivially_copyable_v<Record>, "both are read straight out of the mapping");
+
+
+private:
+	static constexpr uint64_t min_capacity = 256; // records the file starts with room for
+
+	std::vector<Record> m_memory{};
+	std::string m_path{};
+	MappedFile m_file{};
+	uint64_t m_capacity = 0; // records the mapping has room for
+
+	[[nodiscard]] Header* header() const { return reinterpret_cast<Header*>(m_file.data()); }
+	[[nodiscard]] Record* records() const { return reinterpret_cast<Record*>(m_file.data() + sizeof(Header)); }
+
+	[[nodiscard]] const Record& record(const unsigned i) const { return m_file.isOpen() ? records()[i] : m_memory[i]; }
+
+	// sizes the file to room for `capacity` records and maps all of it
+	bool reserve(const uint64_t capacity)
+	{
+		if (!m_file.resize(sizeof(Header) + capacity * sizeof(Record)))
+			return false;
+		m_file.adviseRandom(); // opponents are picked all over the file
+		m_capacity = capacity;
+		return true;
+	}
+
+
+public:
+	// moves the archive to the file at `path`. keep: the file is an archive written before and its records replace the
+	// ones in memory, otherwise it is started over with the ones in memory. fails (and stays as it was) on a file that
+	// cannot be opened or mapped, or that holds networks of another shape
+	bool open(const std::string& path, const bool keep)
+	{
+		SnapshotArchive opened{};
+		opened.m_path = path;
+		if (!opened.m_file.open(path, keep ? MappedFile::Keep : MappedFile::Create))
+		{
+			std::cerr << "[error]: cannot open the snapshot archive " << path << "\n";
+			return false;
+		}
+
+		const uint64_t existing = opened.m_file.size();
+		if (keep && existing >= sizeof(Header))
+		{
+			opened.m_file.adviseRandom();
+			opened.m_capacity = (existing - sizeof(Header)) / sizeof(Record);
+
+			const Header& header = *opened.header();
+			if (std::memcmp(header.magic, file_magic, sizeof(file_magic)) != 0 || header.version != version
+				|| header.parameters != NeuralNetwork::parameterCount || header.stride != sizeof(Record) || header.count > opened.m_capacity)
+			{
+				std::cerr << "[error]: " << path << " is not a snapshot archive of this network's shape\n";
+				return false;
+			}
+		}
+		else
+		{
+			if (!opened.reserve(std::max(min_capacity, static_cast<uint64_t>(m_memory.size()) * 2)))
+				return false;
+
+			Header& header = *opened.header();
+			std::memcpy(header.magic, file_magic, sizeof(file_magic));
+			header.version = version;
+			header.parameters = NeuralNetwork::parameterCount;
+			header.stride = sizeof(Record);
+			header.reserved = 0;
+			header.count = 0;
+			if (!keep)
+			{
+				std::copy(m_memory.begin(), m_memory.end(), opened.records());
+				header.count = m_memory.size();
+			}
+		}
+
+		std::swap(m_memory, opened.m_memory);
+		std::swap(m_path, opened.m_path);
+		std::swap(m_capacity, opened.m_capacity);
+		m_file.swap(opened.m_file);
+		return true;
+	}
+
+	void close()
+	{
+		m_file.close();
+		m_capacity = 0;
+	}
+
+	[[nodiscard]] bool mapped() const { return m_file.isOpen(); }
+	[[nodiscard]] const std::string& path() const { return m_path; }
+	[[nodiscard]] unsigned size() const { return m_file.isOpen() ? static_cast<unsigned>(header()->count) : static_cast<unsigned>(m_memory.size()); }
+
+	// copies `network` in behind the last record, the count moves on once the record is complete
+	bool append(const NeuralNetwork& network, const unsigned generation, const float score)
+	{
+		Record written{ generation, score, {} };
+		std::ranges::copy(network.parameterSpan(), written.parameters.begin());
+
+		if (!m_file.isOpen())
+		{
+			m_memory.push_back(written);
+			return true;
+		}
+
+		const uint64_t count = header()->count;
+		if (count == m_capacity && !reserve(m_capacity * 2))
+		{
+			std::cerr << "[error]: cannot grow the snapshot archive " << m_path << "\n";
+			return false;
+		}
+
+		records()[count] = written;
+		header()->count = count + 1;
+		return true;
+	}
+
+	// copies network i's parameters into `network`, the first time touches its pages in from the file
+	void load(const unsigned i, NeuralNetwork* network) const
+	{
+		std::ranges::copy(record(i).parameters, network->parameterSpan().begin());
+	}
+
+	[[nodiscard]] unsigned generation(const unsigned i) const { return record(i).generation; }
+	[[nodiscard]] float score(const unsigned i) const { return record(i).score; }
+
+	// forgets every record from `count` on, the file keeps its size and the next appends overwrite them
+	void truncate(const unsigned count)
+	{
+		if (m_file.isOpen())
+			header()->count = std::min<uint64_t>(header()->count, count);
+		else if (count < m_memory.size())
+			m_memory.resize(count);
+	}
+
+	// a crash of the process loses nothing that was appended, the mapping is shared with the page cache. this only
+	// asks the os to write it back
+	void flush() const { m_file.flush(); }
+};
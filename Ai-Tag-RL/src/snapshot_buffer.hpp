@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <type_traits>
+
+
+// a lock-free, double-buffered hand over of a small trivially copyable value from one writer thread to one reader.
+// the writer always fills the slot the reader is *not* being pointed at and then flips `m_latest`, so it never
+// waits on the reader. every slot carries a sequence number (odd while it is being written) so in the rare case the
+// writer laps the reader and starts overwriting the slot mid-copy, the reader notices and simply copies again
+template<class T>
+class SnapshotBuffer
+{
+	static_assert(std::is_trivially_copyable_v<T>, "snapshots are copied byte for byte");
+
+	struct Slot
+	{
+		std::atomic<unsigned> sequence = 0;
+		T value{};
+	};
+
+	Slot m_slots[2];
+	std::atomic<unsigned> m_latest = 0;
+	std::atomic<unsigned> m_published = 0; // total publishes, lets the reader skip work when nothing changed
+
+
+public:
+	// writer side. `fill` writes the new snapshot in place so nothing is copied twice
+	template<typename Fill>
+	void publish(Fill&& fill)
+	{
+		const unsigned index = 1 - m_latest.load(std::memory_order_relaxed);
+		Slot& slot = m_slots[index];
+
+		slot.sequence.fetch_add(1, std::memory_order_relaxed); // odd: being written
+		std::atomic_thread_fence(std::memory_order_release);
+		fill(slot.value);
+		slot.sequence.fetch_add(1, std::memory_order_release); // even: complete
+
+		m_latest.store(index, std::memory_order_release);
+		m_published.fetch_add(1, std::memory_order_release);
+	}
+
+	// reader side, copies the newest complete snapshot into `out`. returns false if nothing has been published yet
+	bool read(T& out) const
+	{
+		if (m_published.load(std::memory_order_acquire) == 0)
+			return false;
+
+		while (true)
+		{
+			const Slot& slot = m_slots[m_latest.load(std::memory_order_acquire)];
+
+			const unsigned before = slot.sequence.load(std::memory_order_acquire);
+			if (before & 1u)
+				continue;
+
+			out = slot.value;
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			if (slot.sequence.load(std::memory_order_relaxed) == before)
+				return true;
+		}
+	}
+
+	[[nodiscard]] unsigned publishCount() const { return m_published.load(std::memory_order_acquire); }
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "utility.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+
+// a uniform grid laid over every game's arena. a cell is one collision distance wide, so whatever touches an agent
+// is in one of the 3x3 cells around it. each cell is an intrusive doubly linked list threaded through the agent
+// indices, and an agent is only unlinked and relinked when it crosses into another cell, so keeping the grid up to
+// date as the agents move costs a compare per move
+class SpatialGrid
+{
+public:
+	static constexpr int32_t none = -1;
+
+	void resize(const CircularBorder& bounds, const float cellSize, const unsigned games, const unsigned agents)
+	{
+		m_origin = bounds.position - sf::Vector2f{ bounds.radius, bounds.radius };
+		m_cellSize = cellSize;
+		m_inverseCell = 1.f / cellSize;
+		m_side = std::max(1, static_cast<int>(std::ceil(bounds.radius * 2.f / cellSize)));
+		m_cellsPerGame = static_cast<unsigned>(m_side * m_side);
+
+		m_head.assign(static_cast<size_t>(games) * m_cellsPerGame, none);
+		m_cell.assign(agents, none);
+		m_next.assign(agents, none);
+		m_prev.assign(agents, none);
+	}
+
+	// files `agent` of `game` under the cell at `position`, nothing happens unless it changed cell
+	void place(const unsigned agent, const unsigned game, const sf::Vector2f& position)
+	{
+		const int32_t cell = static_cast<int32_t>(game * m_cellsPerGame + column(position.y, m_origin.y) * m_side + column(position.x, m_origin.x));
+		if (m_cell[agent] == cell)
+			return;
+
+		unlink(agent);
+
+		m_cell[agent] = cell;
+		m_prev[agent] = none;
+		m_next[agent] = m_head[cell];
+		if (m_head[cell] != none)
+			m_prev[m_head[cell]] = static_cast<int32_t>(agent);
+		m_head[cell] = static_cast<int32_t>(agent);
+	}
+
+	// writes every agent of `game` filed in the 3x3 cells around `position` (whoever stands there included) to
+	// `nearby`, at most `capacity` of them, and returns how many it wrote. they are copied out rather than visited in
+	// place because colliding with one can move agents between cells
+	unsigned gather(const unsigned game, const sf::Vector2f& position, unsigned* nearby, const unsigned capacity) const
+	{
+		const int cx = column(position.x, m_origin.x);
+		const int cy = column(position.y, m_origin.y);
+
+		unsigned count = 0;
+		for (int y = std::max(cy - 1, 0); y <= std::min(cy + 1, m_side - 1); ++y)
+		{
+			for (int x = std::max(cx - 1, 0); x <= std::min(cx + 1, m_side - 1); ++x)
+			{
+				for (int32_t agent = m_head[game * m_cellsPerGame + y * m_side + x]; agent != none && count < capacity; agent = m_next[agent])
+					nearby[count++] = static_cast<unsigned>(agent);
+			}
+		}
+
+		return count;
+	}
+
+	// calls visit(agent) for every agent of `game` filed in the square ring of cells `ring` cells out from the one at
+	// `position` (ring 0 is that cell). returns false once the whole ring lies off the grid, so there is nothing
+	// further out either. the grid must not change while visiting
+	template<typename Visit>
+	bool visitRing(const unsigned game, const sf::Vector2f& position, const int ring, Visit&& visit) const
+	{
+		const int x0 = column(position.x, m_origin.x) - ring, x1 = x0 + 2 * ring;
+		const int y0 = column(position.y, m_origin.y) - ring, y1 = y0 + 2 * ring;
+		if (x0 < 0 && y0 < 0 && x1 >= m_side && y1 >= m_side)
+			return false;
+
+		const auto visitCell = [&](const int x, const int y)
+		{
+			for (int32_t agent = m_head[game * m_cellsPerGame + y * m_side + x]; agent != none; agent = m_next[agent])
+				visit(static_cast<unsigned>(agent));
+		};
+
+		for (int y = std::max(y0, 0); y <= std::min(y1, m_side - 1); ++y)
+		{
+			if (y == y0 || y == y1)
+			{
+				for (int x = std::max(x0, 0); x <= std::min(x1, m_side - 1); ++x)
+					visitCell(x, y);
+				continue;
+			}
+
+			if (x0 >= 0)
+				visitCell(x0, y);
+			if (x1 < m_side)
+				visitCell(x1, y);
+		}
+		return true;
+	}
+
+	// the cell `agent` is filed under, it changes when place() moves it
+	[[nodiscard]] int32_t cellOf(const unsigned agent) const { return m_cell[agent]; }
+
+	// nothing filed in ring `ring` or further out is closer than this to a point in ring 0
+	[[nodiscard]] float ringDistance(const int ring) const { return static_cast<float>(std::max(ring - 1, 0)) * m_cellSize; }
+
+
+private:
+	sf::Vector2f m_origin{};
+	float m_cellSize = 1.f;
+	float m_inverseCell = 1.f;
+	int m_side = 1;
+	unsigned m_cellsPerGame = 1;
+
+	std::vector<int32_t> m_head; // first agent of every cell of every game
+	std::vector<int32_t> m_cell; // the cell each agent is filed under
+	std::vector<int32_t> m_next;
+	std::vector<int32_t> m_prev;
+
+	// agents outside the arena (before the border pushes them back) are filed under the nearest edge cell,
+	// which keeps anything within a cell of them within a cell
+	[[nodiscard]] int column(const float coordinate, const float origin) const
+	{
+		return static_cast<int>(std::clamp((coordinate - origin) * m_inverseCell, 0.f, static_cast<float>(m_side - 1)));
+	}
+
+	void unlink(const unsigned agent)
+	{
+		const int32_t cell = m_cell[agent];
+		if (cell == none)
+			return;
+
+		if (m_prev[agent] != none)
+			m_next[m_prev[agent]] = m_next[agent];
+		else
+			m_head[cell] = m_next[agent];
+
+		if (m_next[agent] != none)
+			m_prev[m_next[agent]] = m_prev[agent];
+	}
+};
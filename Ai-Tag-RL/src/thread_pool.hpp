@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// a fixed set of worker threads used to split a range of independent work (games) into chunks.
+// every worker owns a queue of chunks, once its own queue runs dry it steals from the back of another
+// worker's queue so a slow core or an expensive chunk never leaves the rest of the machine idle.
+// the calling thread takes part as worker 0 and parallelFor() only returns once every chunk has been run,
+// which makes it the barrier between stepping the games and the evolution step
+class WorkStealingPool
+{
+	struct Chunk
+	{
+		unsigned begin;
+		unsigned end;
+	};
+
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<Chunk> chunks;
+	};
+
+	// how long a worker spins looking for new work before going to sleep, frames are dispatched back to back
+	// so most of the time the next batch arrives before the spin runs out
+	static constexpr unsigned spinIterations = 4000;
+
+	std::vector<std::thread> m_threads{};
+	std::vector<std::unique_ptr<WorkerQueue>> m_queues{};
+
+	std::function<void(unsigned, unsigned, unsigned)> m_task{};
+	std::atomic<unsigned> m_pendingChunks = 0;
+	std::atomic<unsigned> m_batch = 0;
+	std::atomic<bool> m_stop = false;
+
+	std::mutex m_wakeMutex{};
+	std::condition_variable m_wakeCondition{};
+
+
+public:
+	explicit WorkStealingPool(const unsigned threadCount)
+	{
+		const unsigned total = threadCount == 0 ? 1 : threadCount;
+
+		m_queues.reserve(total);
+		for (unsigned i = 0; i < total; ++i)
+			m_queues.push_back(std::make_unique<WorkerQueue>());
+
+		m_threads.reserve(total - 1);
+		for (unsigned i = 1; i < total; ++i)
+			m_threads.emplace_back([this, i] { workerLoop(i); });
+	}
+
+	~WorkStealingPool()
+	{
+		{
+			std::lock_guard lock(m_wakeMutex);
+			m_stop = true;
+		}
+		m_wakeCondition.notify_all();
+
+		for (std::thread& thread : m_threads)
+			thread.join();
+	}
+
+	WorkStealingPool(const WorkStealingPool&) = delete;
+	WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+	[[nodiscard]] unsigned size() const { return static_cast<unsigned>(m_queues.size()); }
+
+	// the number of threads to use when the settings ask for "all of them"
+	static unsigned hardwareThreads()
+	{
+		const unsigned threads = std::thread::hardware_concurrency();
+		return threads == 0 ? 1 : threads;
+	}
+
+
+	// runs func(begin, end, worker) over [0, count) in chunks of chunkSize and blocks until all of them are done.
+	// func must only touch the items inside its own range
+	template<typename Func>
+	void parallelFor(const unsigned count, const unsigned chunkSize, Func&& func)
+	{
+		if (count == 0)
+			return;
+
+		// nothing to share, skip the queues completely
+		if (size() == 1 || count <= chunkSize)
+		{
+			func(0u, count, 0u);
+			return;
+		}
+
+		m_task = std::forward<Func>(func);
+
+		// dealing the chunks out round robin so every worker starts with a fair share
+		const unsigned step = chunkSize == 0 ? 1 : chunkSize;
+		m_pendingChunks.store((count + step - 1) / step, std::memory_order_release);
+
+		unsigned worker = 0;
+		for (unsigned begin = 0; begin < count; begin += step)
+		{
+			WorkerQueue& queue = *m_queues[worker];
+			{
+				std::lock_guard lock(queue.mutex);
+				queue.chunks.push_back({ begin, std::min(begin + step, count) });
+			}
+			worker = (worker + 1) % size();
+		}
+
+		{
+			std::lock_guard lock(m_wakeMutex);
+			m_batch.fetch_add(1, std::memory_order_release);
+		}
+		m_wakeCondition.notify_all();
+
+		// the calling thread works too, then waits for the stragglers (the barrier)
+		drainQueues(0);
+		while (m_pendingChunks.load(std::memory_order_acquire) != 0)
+		{
+			if (!runOneChunk(0))
+				std::this_thread::yield();
+		}
+	}
+
+
+private:
+	bool popOwn(const unsigned worker, Chunk& chunk)
+	{
+		WorkerQueue& queue = *m_queues[worker];
+		std::lock_guard lock(queue.mutex);
+		if (queue.chunks.empty())
+			return false;
+
+		chunk = queue.chunks.front();
+		queue.chunks.pop_front();
+		return true;
+	}
+
+	bool steal(const unsigned worker, Chunk& chunk)
+	{
+		for (unsigned offset = 1; offset < size(); ++offset)
+		{
+			WorkerQueue& victim = *m_queues[(worker + offset) % size()];
+			std::lock_guard lock(victim.mutex);
+			if (victim.chunks.empty())
+				continue;
+
+			chunk = victim.chunks.back();
+			victim.chunks.pop_back();
+			return true;
+		}
+		return false;
+	}
+
+	bool runOneChunk(const unsigned worker)
+	{
+		Chunk chunk{};
+		if (!popOwn(worker, chunk) && !steal(worker, chunk))
+			return false;
+
+		m_task(chunk.begin, chunk.end, worker);
+		m_pendingChunks.fetch_sub(1, std::memory_order_acq_rel);
+		return true;
+	}
+
+	void drainQueues(const unsigned worker)
+	{
+		while (runOneChunk(worker)) {}
+	}
+
+	void workerLoop(const unsigned worker)
+	{
+		unsigned seenBatch = 0;
+		while (true)
+		{
+			// spinning first, sleeping only if no work shows up for a while
+			unsigned spins = 0;
+			while (m_batch.load(std::memory_order_acquire) == seenBatch && !m_stop.load(std::memory_order_relaxed))
+			{
+				if (++spins < spinIterations)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				std::unique_lock lock(m_wakeMutex);
+				m_wakeCondition.wait(lock, [&] { return m_batch.load() != seenBatch || m_stop.load(); });
+			}
+
+			if (m_stop.load())
+				return;
+
+			seenBatch = m_batch.load(std::memory_order_acquire);
+			drainQueues(worker);
+		}
+	}
+};
@@ -6,6 +6,9 @@
 #include <boost/functional/hash.hpp>
 #include <iostream>
 #include <random>
+#include <atomic>
+#include <sstream>
+#include <chrono>
 
 
 // a class used to get a more stable and accurate reading of framerates by averaging out the last N
@@ -492,22 +495,71 @@ public:
 
 
 
-// a wrapper to make generating random floats and integers more convinient
-inline static std::random_device dev;
-inline static std::mt19937 rng{ dev() }; // random number generator
+// a counter based random number generator (SplitMix64 used as a hash of key + counter). the n-th number of a stream
+// only depends on the stream's key and n, so streams are cheap to create, never shared, and any stream can be
+// replayed exactly from its key
+struct CounterRng
+{
+	uint64_t key     = 0;
+	uint64_t counter = 0;
+
+	static constexpr uint64_t golden = 0x9E3779B97F4A7C15ull;
+
+	static constexpr uint64_t mix(uint64_t z)
+	{
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	// the key of stream `stream` used for `purpose` in generation `generation` of the run seeded with `runSeed`
+	static constexpr uint64_t streamKey(const uint64_t runSeed, const uint64_t purpose, const uint64_t generation, const uint64_t stream)
+	{
+		return mix(mix(mix(mix(runSeed) + purpose * golden) + generation * golden) + stream * golden);
+	}
+
+	uint64_t next() { return mix(key + (++counter) * golden); }
+
+	// the top 24 bits make an exactly representable float in [0, 1)
+	float uniform01() { return static_cast<float>(next() >> 40) * 0x1.0p-24f; }
+};
+
+
+// a wrapper to make generating random floats and integers more convinient. every thread draws from its own
+// CounterRng stream so nothing is shared between threads. work that has to be reproducible (e.g. mutating game i in
+// generation g) re-seeds the calling thread's stream with seed(Mutation, g, i) first
 struct RandomDist
 {
-	// random engines
-	inline static std::uniform_real_distribution<float> float01_dist{ 0.f, 1.f };
-	inline static std::uniform_real_distribution<float> float11_dist{ -1.f, 1.f };
-	inline static std::uniform_int<int> int01_dist{ 0, 1 };
-	inline static std::uniform_int<int> int11_dist{ -1, 1 };
+	// what a stream is used for, so game 3's mutation and game 3's reset never draw the same numbers
+	enum Purpose : uint64_t { Init, Mutation, Reset, Positions, Evolution, Evaluation, Noise, Policy };
+
+	inline static std::atomic<uint64_t> runSeed{ std::random_device{}() };
+	inline static std::atomic<uint64_t> threadsSeen{ 0 };
+
+	// a thread which never called seed() still gets its own stream, numbered in the order threads first draw
+	inline static thread_local CounterRng stream{ CounterRng::streamKey(runSeed.load(), Init, 0, threadsSeen.fetch_add(1)), 0 };
+
+	static void setRunSeed(const uint64_t seed) { runSeed = seed; }
+	static void seed(const Purpose purpose, const uint64_t generation, const uint64_t streamIndex)
+	{
+		stream = { CounterRng::streamKey(runSeed.load(std::memory_order_relaxed), purpose, generation, streamIndex), 0 };
+	}
 
 	// basic random functions 11 = range(-1, 1), 01 = range(0, 1)
-	static float rand11float() { return float11_dist(rng); }
-	static float rand01float() { return float01_dist(rng); }
-	static int   rand01int() { return int01_dist(rng); }
-	static int   rand11int() { return int11_dist(rng); }
+	static float rand11float() { return stream.uniform01() * 2.f - 1.f; }
+	static float rand01float() { return stream.uniform01(); }
+	static int   rand01int() { return static_cast<int>(stream.next() >> 63); }
+	static int   rand11int() { return randRange(-1, 1); }
+
+	// fills `count` floats with uniforms in [min, max), the batch form used by the mutation code
+	static void fillUniform(float* values, const size_t count, const float min = 0.f, const float max = 1.f)
+	{
+		CounterRng local = stream; // working on a copy keeps the state in registers for the whole loop
+		const float scale = max - min;
+		for (size_t i = 0; i < count; ++i)
+			values[i] = min + local.uniform01() * scale;
+		stream = local;
+	}
 
 
 	// more complex random generation. specified ranges
@@ -515,16 +567,16 @@ struct RandomDist
 	template <typename Type>
 	static Type randRange(const Type min, const Type max)
 	{
-		// Check if the Type is an integer type
+		// Check if the Type is an integer type, both ends are included
 		if constexpr (std::is_integral_v<Type>)
 		{
-			std::uniform_int_distribution<Type> int_dist{ min, max };
-			return int_dist(rng);
+			const uint64_t span = static_cast<uint64_t>(max) - static_cast<uint64_t>(min) + 1;
+			if (span == 0) return static_cast<Type>(stream.next());
+			return static_cast<Type>(static_cast<uint64_t>(min) + stream.next() % span);
 		}
 		else
 		{
-			std::uniform_real_distribution<Type> float_dist{ min, max };
-			return float_dist(rng);
+			return min + static_cast<Type>(stream.uniform01()) * (max - min);
 		}
 	}
 